@@ -0,0 +1,159 @@
+// Contention benchmark for the WebSocketClient inbound queue.
+//
+// A producer thread stands in for the websocketpp io thread and pushes
+// `player_moved`-sized payloads at a fixed rate; the consumer mimics the render
+// loop and drains once per frame. Compares the former mutex + deque queue with
+// the SpscRing that replaced it.
+//
+//   inbound_queue_bench [msgs_per_sec=20000] [seconds=3] [fps=60]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SpscRing.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+class MutexDequeQueue {
+ public:
+  void push(const std::string& payload) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(payload);
+  }
+
+  template <typename Fn>
+  std::size_t drain(Fn&& fn) {
+    std::vector<std::string> out;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      out.reserve(queue_.size());
+      while (!queue_.empty()) {
+        out.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+    }
+    for (const auto& payload : out) {
+      fn(payload);
+    }
+    return out.size();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::deque<std::string> queue_;
+};
+
+class RingQueue {
+ public:
+  void push(const std::string& payload) {
+    while (!ring_.tryPush([&payload](std::string& slot) { slot.assign(payload); })) {
+      std::this_thread::yield();
+    }
+  }
+
+  template <typename Fn>
+  std::size_t drain(Fn&& fn) {
+    const auto view = ring_.acquire();
+    for (const auto& payload : view) {
+      fn(payload);
+    }
+    ring_.release(view);
+    return view.size();
+  }
+
+ private:
+  SpscRing<std::string> ring_{4096};
+};
+
+struct Result {
+  std::size_t delivered = 0;
+  std::size_t bytes = 0;
+  double pushP50Us = 0.0;
+  double pushP99Us = 0.0;
+  double pushMaxUs = 0.0;
+  double drainP50Us = 0.0;
+  double drainP99Us = 0.0;
+  double drainMaxUs = 0.0;
+};
+
+double percentile(std::vector<double>& samples, double p) {
+  if (samples.empty()) {
+    return 0.0;
+  }
+  const std::size_t idx = std::min(samples.size() - 1, static_cast<std::size_t>(p * static_cast<double>(samples.size())));
+  std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(idx), samples.end());
+  return samples[idx];
+}
+
+template <typename Queue>
+Result runCase(int msgsPerSec, int seconds, int fps) {
+  Queue queue;
+  const std::string payload =
+      R"({"type":"player_moved","player":{"id":"p-00042","name":"bench","class":"Warrior","x":17,"y":23,"hp":87,"maxHp":100}})";
+  const std::size_t total = static_cast<std::size_t>(msgsPerSec) * static_cast<std::size_t>(seconds);
+
+  std::vector<double> pushUs;
+  pushUs.reserve(total);
+  std::vector<double> drainUs;
+  std::size_t delivered = 0;
+  std::size_t bytes = 0;
+
+  std::thread producer([&]() {
+    const auto interval = std::chrono::nanoseconds(1000000000LL / std::max(1, msgsPerSec));
+    auto next = Clock::now();
+    for (std::size_t i = 0; i < total; ++i) {
+      next += interval;
+      while (Clock::now() < next) {
+        std::this_thread::yield();
+      }
+      const auto t0 = Clock::now();
+      queue.push(payload);
+      pushUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+    }
+  });
+
+  const auto frame = std::chrono::microseconds(1000000 / std::max(1, fps));
+  while (delivered < total) {
+    std::this_thread::sleep_for(frame);
+    const auto t0 = Clock::now();
+    delivered += queue.drain([&bytes](const std::string& p) { bytes += p.size(); });
+    drainUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+  }
+  producer.join();
+
+  Result r;
+  r.delivered = delivered;
+  r.bytes = bytes;
+  r.pushP50Us = percentile(pushUs, 0.50);
+  r.pushP99Us = percentile(pushUs, 0.99);
+  r.pushMaxUs = pushUs.empty() ? 0.0 : *std::max_element(pushUs.begin(), pushUs.end());
+  r.drainP50Us = percentile(drainUs, 0.50);
+  r.drainP99Us = percentile(drainUs, 0.99);
+  r.drainMaxUs = drainUs.empty() ? 0.0 : *std::max_element(drainUs.begin(), drainUs.end());
+  return r;
+}
+
+void print(const char* name, const Result& r) {
+  std::printf("%-14s delivered=%-8zu bytes=%-10zu push p50=%7.2fus p99=%7.2fus max=%8.1fus | drain p50=%8.1fus p99=%8.1fus max=%8.1fus\n",
+              name, r.delivered, r.bytes, r.pushP50Us, r.pushP99Us, r.pushMaxUs, r.drainP50Us, r.drainP99Us, r.drainMaxUs);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int msgsPerSec = argc > 1 ? std::atoi(argv[1]) : 20000;
+  const int seconds = argc > 2 ? std::atoi(argv[2]) : 3;
+  const int fps = argc > 3 ? std::atoi(argv[3]) : 60;
+
+  std::printf("inbound queue contention: %d msgs/s for %ds, consumer at %d fps\n", msgsPerSec, seconds, fps);
+  print("mutex+deque", runCase<MutexDequeQueue>(msgsPerSec, seconds, fps));
+  print("spsc ring", runCase<RingQueue>(msgsPerSec, seconds, fps));
+  return 0;
+}
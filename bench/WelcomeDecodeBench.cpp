@@ -0,0 +1,165 @@
+// Decode cost of a large `welcome` snapshot: the nlohmann DOM path versus the
+// streaming (SAX) decoder in WorldProtocol.cpp. Reports mean decode time and
+// peak heap growth during one decode, and checks that both paths agree.
+//
+//   welcome_decode_bench [map_size=500] [entities=5000] [iterations=5]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <string>
+
+#include "WorldProtocol.hpp"
+#include "nlohmann/json.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+using json = nlohmann::json;
+
+// Live heap bytes, tracked by the replaced operator new/delete below.
+std::atomic<std::size_t> gLiveBytes{0};
+std::atomic<std::size_t> gPeakBytes{0};
+constexpr std::size_t kHeader = alignof(std::max_align_t);
+
+std::string makeWelcome(int mapSize, int entities) {
+  static const char kTiles[] = "gggggwf#";
+  json rows = json::array();
+  for (int y = 0; y < mapSize; ++y) {
+    std::string row(static_cast<std::size_t>(mapSize), 'g');
+    for (int x = 0; x < mapSize; ++x) {
+      row[static_cast<std::size_t>(x)] = kTiles[(x * 7 + y * 13) % 8];
+    }
+    rows.push_back(std::move(row));
+  }
+  json players = json::array();
+  json mobs = json::array();
+  for (int i = 0; i < entities; ++i) {
+    players.push_back({{"id", "p" + std::to_string(i)}, {"name", "Player" + std::to_string(i)}, {"class", "Mage"},
+                       {"x", i % mapSize}, {"y", (i * 3) % mapSize}, {"hp", 80}, {"maxHp", 100}, {"level", 5}});
+    mobs.push_back({{"id", "m" + std::to_string(i)}, {"name", "Wolf"}, {"x", (i * 5) % mapSize},
+                    {"y", (i * 11) % mapSize}, {"hp", 30}, {"maxHp", 30}, {"aggressive", i % 2 == 0}});
+  }
+  const json msg{
+      {"type", "welcome"},
+      {"seq", 1},
+      {"playerId", "p0"},
+      {"map", {{"width", mapSize}, {"height", mapSize}, {"tiles", std::move(rows)}}},
+      {"players", std::move(players)},
+      {"npcs", json::array({{{"id", "n1"}, {"name", "Elder"}, {"x", 3}, {"y", 4}}})},
+      {"mobs", std::move(mobs)},
+      {"character", {{"pos_x", 12}, {"pos_y", 9}}},
+  };
+  return msg.dump();
+}
+
+struct Result {
+  double meanMs = 0.0;
+  std::size_t peakBytes = 0;
+  DecodedMessage decoded;
+};
+
+Result run(const std::string& payload, std::size_t threshold, int iterations) {
+  setStreamingWelcomeThreshold(threshold);
+  Result r;
+  double totalMs = 0.0;
+  for (int i = 0; i < iterations; ++i) {
+    DecodedMessage out;
+    const std::size_t base = gLiveBytes.load();
+    gPeakBytes.store(base);
+    const auto t0 = Clock::now();
+    decodeWorldMessage(payload, false, out);
+    totalMs += std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    r.peakBytes = std::max(r.peakBytes, gPeakBytes.load() - base);
+    r.decoded = std::move(out);
+  }
+  r.meanMs = totalMs / std::max(1, iterations);
+  return r;
+}
+
+bool sameWelcome(const DecodedMessage& a, const DecodedMessage& b) {
+  const auto* wa = std::get_if<Welcome>(&a.event);
+  const auto* wb = std::get_if<Welcome>(&b.event);
+  if (!wa || !wb || a.seq != b.seq || wa->selfId != wb->selfId || wa->selfX != wb->selfX ||
+      wa->selfY != wb->selfY || wa->map.has_value() != wb->map.has_value()) {
+    return false;
+  }
+  if (wa->map && (wa->map->width != wb->map->width || wa->map->tiles != wb->map->tiles)) {
+    return false;
+  }
+  const auto sameIds = [](const auto& x, const auto& y) {
+    if (x.has_value() != y.has_value() || (x && x->size() != y->size())) {
+      return false;
+    }
+    for (std::size_t i = 0; x && i < x->size(); ++i) {
+      if ((*x)[i].id != (*y)[i].id || (*x)[i].x != (*y)[i].x || (*x)[i].y != (*y)[i].y) {
+        return false;
+      }
+    }
+    return true;
+  };
+  return sameIds(wa->players, wb->players) && sameIds(wa->npcs, wb->npcs) && sameIds(wa->mobs, wb->mobs);
+}
+}  // namespace
+
+void* operator new(std::size_t size) {
+  void* block = std::malloc(size + kHeader);
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  *static_cast<std::size_t*>(block) = size;
+  const std::size_t live = gLiveBytes.fetch_add(size) + size;
+  std::size_t peak = gPeakBytes.load();
+  while (live > peak && !gPeakBytes.compare_exchange_weak(peak, live)) {
+  }
+  return static_cast<char*>(block) + kHeader;
+}
+
+void operator delete(void* ptr) noexcept {
+  if (!ptr) {
+    return;
+  }
+  void* block = reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(ptr) - kHeader);
+  gLiveBytes.fetch_sub(*static_cast<std::size_t*>(block));
+  std::free(block);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  operator delete(ptr);
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete[](void* ptr) noexcept {
+  operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  operator delete(ptr);
+}
+
+int main(int argc, char** argv) {
+  const int mapSize = argc > 1 ? std::atoi(argv[1]) : 500;
+  const int entities = argc > 2 ? std::atoi(argv[2]) : 5000;
+  const int iterations = argc > 3 ? std::atoi(argv[3]) : 5;
+
+  const std::string payload = makeWelcome(mapSize, entities);
+  std::printf("welcome decode: %dx%d map, %d players + %d mobs, %.1f KiB payload, %d iterations\n", mapSize, mapSize,
+              entities, entities, static_cast<double>(payload.size()) / 1024.0, iterations);
+
+  const Result dom = run(payload, std::numeric_limits<std::size_t>::max(), iterations);
+  const Result sax = run(payload, 0, iterations);
+  std::printf("%-10s mean=%8.2f ms  peak heap=%8.1f KiB\n", "dom", dom.meanMs,
+              static_cast<double>(dom.peakBytes) / 1024.0);
+  std::printf("%-10s mean=%8.2f ms  peak heap=%8.1f KiB\n", "streaming", sax.meanMs,
+              static_cast<double>(sax.peakBytes) / 1024.0);
+  const bool same = sameWelcome(dom.decoded, sax.decoded);
+  std::printf("results %s\n", same ? "match" : "DIFFER");
+  return same ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+// Exponential reconnect delay with "equal jitter": each attempt waits a random
+// time in [d/2, d], where d doubles from `initialMs` up to `maxMs`.
+class ExponentialBackoff {
+ public:
+  explicit ExponentialBackoff(std::uint32_t initialMs = 500, std::uint32_t maxMs = 30000)
+      : initialMs_(initialMs), maxMs_(std::max(initialMs, maxMs)), rng_(std::random_device{}()) {}
+
+  std::uint32_t nextDelayMs() {
+    const std::uint32_t ceiling = currentCeilingMs();
+    if (attempt_ < 31) {
+      ++attempt_;
+    }
+    std::uniform_int_distribution<std::uint32_t> dist(ceiling / 2, ceiling);
+    return dist(rng_);
+  }
+
+  void reset() { attempt_ = 0; }
+  std::uint32_t attempts() const { return attempt_; }
+
+ private:
+  std::uint32_t currentCeilingMs() const {
+    std::uint64_t ceiling = initialMs_;
+    for (std::uint32_t i = 0; i < attempt_ && ceiling < maxMs_; ++i) {
+      ceiling *= 2;
+    }
+    return static_cast<std::uint32_t>(std::min<std::uint64_t>(ceiling, maxMs_));
+  }
+
+  std::uint32_t initialMs_;
+  std::uint32_t maxMs_;
+  std::uint32_t attempt_ = 0;
+  std::mt19937 rng_;
+};
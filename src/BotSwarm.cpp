@@ -0,0 +1,570 @@
+#include "BotSwarm.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <websocketpp/client.hpp>
+#include <websocketpp/config/asio_no_tls_client.hpp>
+
+#include "HttpAuthClient.hpp"
+#include "WorldProtocol.hpp"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+using Endpoint = websocketpp::client<websocketpp::config::asio_client>;
+using Clock = std::chrono::steady_clock;
+
+constexpr int kReportEverySec = 5;
+constexpr std::size_t kMaxPendingMoves = 64;
+constexpr const char* kBotPassword = "bot-password";
+
+std::atomic<bool> gInterrupted{false};
+
+void onInterrupt(int) { gInterrupted.store(true); }
+
+double msSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Latency in milliseconds: 1 ms buckets below 256 ms, 16 ms buckets up to
+// 4 s, then one overflow bucket. Small enough to keep a few per bot.
+class LatencyHistogram {
+ public:
+  void record(double ms) {
+    ++buckets_[bucketFor(ms)];
+    ++count_;
+    maxMs_ = std::max(maxMs_, ms);
+  }
+
+  void merge(const LatencyHistogram& other) {
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    maxMs_ = std::max(maxMs_, other.maxMs_);
+  }
+
+  std::uint64_t count() const { return count_; }
+  double maxMs() const { return maxMs_; }
+
+  // Upper edge of the bucket holding the p-th percentile; -1 when empty.
+  double percentile(double p) const {
+    if (count_ == 0) {
+      return -1.0;
+    }
+    const auto rank = static_cast<std::uint64_t>(std::max(1.0, p / 100.0 * static_cast<double>(count_)));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        return std::min(upperEdge(i), maxMs_);
+      }
+    }
+    return maxMs_;
+  }
+
+ private:
+  static constexpr std::size_t kFine = 256;
+  static constexpr std::size_t kCoarseWidth = 16;
+  static constexpr std::size_t kBuckets = kFine + (4096 - kFine) / kCoarseWidth + 1;
+
+  static std::size_t bucketFor(double ms) {
+    const auto whole = static_cast<std::size_t>(std::max(0.0, ms));
+    if (whole < kFine) {
+      return whole;
+    }
+    return std::min(kBuckets - 1, kFine + (whole - kFine) / kCoarseWidth);
+  }
+
+  static double upperEdge(std::size_t bucket) {
+    if (bucket < kFine) {
+      return static_cast<double>(bucket + 1);
+    }
+    return static_cast<double>(kFine + (bucket - kFine + 1) * kCoarseWidth);
+  }
+
+  std::array<std::uint32_t, kBuckets> buckets_{};
+  std::uint64_t count_ = 0;
+  double maxMs_ = 0.0;
+};
+
+enum class BotPhase : std::uint8_t { Auth, Connecting, Joining, Playing, Failed, Stopped };
+
+const char* phaseName(BotPhase phase) {
+  switch (phase) {
+    case BotPhase::Auth:
+      return "auth";
+    case BotPhase::Connecting:
+      return "connecting";
+    case BotPhase::Joining:
+      return "joining";
+    case BotPhase::Playing:
+      return "playing";
+    case BotPhase::Failed:
+      return "failed";
+    case BotPhase::Stopped:
+      return "stopped";
+  }
+  return "?";
+}
+
+struct BotStats {
+  BotPhase phase = BotPhase::Auth;
+  std::string status;
+  std::uint64_t msgsIn = 0;
+  std::uint64_t bytesIn = 0;
+  std::uint64_t msgsOut = 0;
+  std::uint64_t bytesOut = 0;
+  double authMs = -1.0;
+  double joinMs = -1.0;     // join sent -> welcome
+  LatencyHistogram move;    // move sent -> own player update acknowledging its input_seq
+  LatencyHistogram attack;  // attack sent -> combat on that target
+};
+
+// One simulated player. HTTP runs on an auth worker; everything after that on
+// whichever pool thread asio picks, so state is guarded by `mutex_`. Handlers
+// capture `this`: the swarm keeps every Bot alive until the pool has stopped.
+class Bot {
+ public:
+  Bot(int index, Endpoint& endpoint, const BotSwarmOptions& options)
+      : index_(index), endpoint_(endpoint), options_(options), rng_(static_cast<std::uint32_t>(index) + 1) {}
+
+  bool authenticate() {
+    const auto started = Clock::now();
+    HttpAuthClient http(options_.httpUrl);
+    const std::string email = "bot" + std::to_string(index_) + "@mmorp.test";
+    AuthResult auth = http.login(email, kBotPassword);
+    if (!auth.ok) {
+      auth = http.reg(email, kBotPassword);
+    }
+    if (!auth.ok) {
+      return fail("auth: " + auth.message);
+    }
+    std::vector<CharacterInfo> characters = http.fetchCharacters(auth.token).items;
+    if (characters.empty()) {
+      static const char* const kClasses[] = {"Warrior", "Mage", "Rogue"};
+      if (auto created = http.createCharacter(auth.token, "Bot" + std::to_string(index_), kClasses[index_ % 3])) {
+        characters.push_back(*created);
+      }
+    }
+    if (characters.empty()) {
+      return fail("no character");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stats_.phase != BotPhase::Auth) {
+      return false;
+    }
+    jwt_ = auth.token;
+    character_ = characters.front();
+    stats_.authMs = msSince(started);
+    stats_.phase = BotPhase::Connecting;
+    return true;
+  }
+
+  void connect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stats_.phase != BotPhase::Connecting) {
+      return;
+    }
+    std::string url = options_.wsUrl;
+    url += (url.find('?') == std::string::npos) ? "?" : "&";
+    url += "token=" + jwt_;
+
+    websocketpp::lib::error_code ec;
+    auto con = endpoint_.get_connection(url, ec);
+    if (ec) {
+      failLocked("connect: " + ec.message());
+      return;
+    }
+    con->append_header("Authorization", "Bearer " + jwt_);
+    con->set_open_handler([this](websocketpp::connection_hdl) { onOpen(); });
+    con->set_message_handler([this](websocketpp::connection_hdl, Endpoint::message_ptr msg) { onMessage(msg); });
+    con->set_close_handler([this](websocketpp::connection_hdl) { onDrop("closed by server"); });
+    con->set_fail_handler([this](websocketpp::connection_hdl hdl) {
+      websocketpp::lib::error_code conEc;
+      auto failed = endpoint_.get_con_from_hdl(hdl, conEc);
+      onDrop(failed ? "connect failed: " + failed->get_ec().message() : std::string("connect failed"));
+    });
+    hdl_ = con->get_handle();
+    endpoint_.connect(con);
+  }
+
+  void stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelTimers();
+    if (stats_.phase == BotPhase::Failed) {
+      return;
+    }
+    stats_.phase = BotPhase::Stopped;
+    if (!hdl_.expired()) {
+      websocketpp::lib::error_code ec;
+      endpoint_.close(hdl_, websocketpp::close::status::going_away, "bot run finished", ec);
+    }
+  }
+
+  BotStats snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+ private:
+  bool fail(const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    failLocked(reason);
+    return false;
+  }
+
+  void failLocked(const std::string& reason) {
+    if (stats_.phase == BotPhase::Stopped) {
+      return;
+    }
+    cancelTimers();
+    stats_.phase = BotPhase::Failed;
+    stats_.status = reason;
+  }
+
+  void cancelTimers() {
+    for (Endpoint::timer_ptr* timer : {&moveTimer_, &attackTimer_}) {
+      if (*timer) {
+        (*timer)->cancel();
+        timer->reset();
+      }
+    }
+  }
+
+  void onOpen() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stats_.phase != BotPhase::Connecting) {
+      return;
+    }
+    stats_.phase = BotPhase::Joining;
+    joinSentAt_ = Clock::now();
+    sendLocked({{"type", "join"},
+                {"character_id", character_.id},
+                {"name", character_.name},
+                {"class", character_.className}});
+  }
+
+  void onDrop(const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hdl_.reset();
+    failLocked(reason);
+  }
+
+  void onMessage(const Endpoint::message_ptr& msg) {
+    DecodedMessage decoded;
+    const bool binary = msg->get_opcode() == websocketpp::frame::opcode::binary;
+    decodeWorldMessage(msg->get_payload(), binary, decoded);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.msgsIn;
+    stats_.bytesIn += msg->get_payload().size();
+    if (stats_.phase != BotPhase::Joining && stats_.phase != BotPhase::Playing) {
+      return;
+    }
+
+    if (const auto* welcome = std::get_if<Welcome>(&decoded.event)) {
+      selfId_ = welcome->selfId.value_or(selfId_);
+      if (welcome->mobs) {
+        mobs_.clear();
+        for (const MobState& mob : *welcome->mobs) {
+          mobs_[mob.id] = mob.alive;
+        }
+      }
+      if (stats_.phase == BotPhase::Joining) {
+        stats_.joinMs = msSince(joinSentAt_);
+        stats_.phase = BotPhase::Playing;
+        scheduleMove();
+        scheduleAttack();
+      }
+    } else if (const auto* upsert = std::get_if<PlayerUpsert>(&decoded.event)) {
+      if (upsert->player.id == selfId_) {
+        acknowledgeMoves(upsert->ackInputSeq);
+      }
+    } else if (const auto* delta = std::get_if<WorldDelta>(&decoded.event)) {
+      // `last_input_seq` in a delta is always the recipient's own.
+      acknowledgeMoves(delta->ackInputSeq);
+    } else if (const auto* mobs = std::get_if<MobUpsert>(&decoded.event)) {
+      for (const MobState& mob : mobs->mobs) {
+        mobs_[mob.id] = mob.alive;
+      }
+    } else if (const auto* combat = std::get_if<Combat>(&decoded.event)) {
+      if (!attackTarget_.empty() && combat->targetId == attackTarget_) {
+        stats_.attack.record(msSince(attackSentAt_));
+        attackTarget_.clear();
+      }
+    }
+  }
+
+  void acknowledgeMoves(std::uint32_t ackInputSeq) {
+    if (ackInputSeq == 0) {
+      return;
+    }
+    while (!pendingMoves_.empty() && pendingMoves_.front().first <= ackInputSeq) {
+      stats_.move.record(msSince(pendingMoves_.front().second));
+      pendingMoves_.pop_front();
+    }
+  }
+
+  void scheduleMove() {
+    moveTimer_ = endpoint_.set_timer(jittered(options_.moveIntervalMs), [this](const websocketpp::lib::error_code& ec) {
+      if (ec) {
+        return;
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stats_.phase != BotPhase::Playing) {
+        return;
+      }
+      static const int kSteps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+      const auto& step = kSteps[std::uniform_int_distribution<int>(0, 3)(rng_)];
+      const std::uint32_t seq = ++inputSeq_;
+      if (pendingMoves_.size() >= kMaxPendingMoves) {
+        pendingMoves_.pop_front();  // only bounds the queue; the dropped move goes unmeasured
+      }
+      pendingMoves_.emplace_back(seq, Clock::now());
+      sendLocked({{"type", "move"}, {"dx", step[0]}, {"dy", step[1]}, {"input_seq", seq}});
+      if (stats_.phase == BotPhase::Playing) {
+        scheduleMove();
+      }
+    });
+  }
+
+  void scheduleAttack() {
+    attackTimer_ =
+        endpoint_.set_timer(jittered(options_.attackIntervalMs), [this](const websocketpp::lib::error_code& ec) {
+          if (ec) {
+            return;
+          }
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (stats_.phase != BotPhase::Playing) {
+            return;
+          }
+          std::vector<const std::string*> alive;
+          for (const auto& [id, isAlive] : mobs_) {
+            if (isAlive) {
+              alive.push_back(&id);
+            }
+          }
+          if (!alive.empty()) {
+            attackTarget_ = *alive[std::uniform_int_distribution<std::size_t>(0, alive.size() - 1)(rng_)];
+            attackSentAt_ = Clock::now();
+            sendLocked({{"type", "attack"}, {"targetId", attackTarget_}, {"mobId", attackTarget_}});
+          }
+          if (stats_.phase == BotPhase::Playing) {
+            scheduleAttack();
+          }
+        });
+  }
+
+  // +-25% so bots started together do not tick in lockstep.
+  long jittered(int intervalMs) {
+    const int spread = std::max(1, intervalMs / 4);
+    return std::max(1, intervalMs + std::uniform_int_distribution<int>(-spread, spread)(rng_));
+  }
+
+  void sendLocked(const json& msg) {
+    const std::string payload = msg.dump();
+    websocketpp::lib::error_code ec;
+    endpoint_.send(hdl_, payload, websocketpp::frame::opcode::text, ec);
+    if (ec) {
+      failLocked("send: " + ec.message());
+      return;
+    }
+    ++stats_.msgsOut;
+    stats_.bytesOut += payload.size();
+  }
+
+  const int index_;
+  Endpoint& endpoint_;
+  const BotSwarmOptions& options_;
+
+  mutable std::mutex mutex_;
+  BotStats stats_;
+  std::mt19937 rng_;
+  std::string jwt_;
+  CharacterInfo character_;
+  std::string selfId_;
+  websocketpp::connection_hdl hdl_;
+  Endpoint::timer_ptr moveTimer_;
+  Endpoint::timer_ptr attackTimer_;
+  Clock::time_point joinSentAt_;
+  std::uint32_t inputSeq_ = 0;
+  std::deque<std::pair<std::uint32_t, Clock::time_point>> pendingMoves_;
+  std::map<std::string, bool> mobs_;  // id -> alive
+  std::string attackTarget_;
+  Clock::time_point attackSentAt_;
+};
+
+std::string formatMs(double ms) {
+  if (ms < 0.0) {
+    return "-";
+  }
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.0f", ms);
+  return buf;
+}
+
+struct SwarmTotals {
+  std::size_t byPhase[6] = {};
+  std::uint64_t msgsIn = 0;
+  std::uint64_t bytesIn = 0;
+  std::uint64_t msgsOut = 0;
+  LatencyHistogram move;
+  LatencyHistogram attack;
+  LatencyHistogram join;
+};
+
+SwarmTotals collect(const std::vector<BotStats>& stats) {
+  SwarmTotals totals;
+  for (const BotStats& s : stats) {
+    ++totals.byPhase[static_cast<std::size_t>(s.phase)];
+    totals.msgsIn += s.msgsIn;
+    totals.bytesIn += s.bytesIn;
+    totals.msgsOut += s.msgsOut;
+    totals.move.merge(s.move);
+    totals.attack.merge(s.attack);
+    if (s.joinMs >= 0.0) {
+      totals.join.record(s.joinMs);
+    }
+  }
+  return totals;
+}
+
+std::vector<BotStats> snapshotAll(const std::vector<std::unique_ptr<Bot>>& bots) {
+  std::vector<BotStats> stats;
+  stats.reserve(bots.size());
+  for (const auto& bot : bots) {
+    stats.push_back(bot->snapshot());
+  }
+  return stats;
+}
+
+void printAggregate(const char* label, const SwarmTotals& totals, std::size_t botCount) {
+  std::printf("[bots] %s playing=%zu/%zu failed=%zu | move p50=%s p95=%s p99=%s ms (n=%llu) | attack p50=%s p95=%s ms"
+              " | join p50=%s ms\n",
+              label, totals.byPhase[static_cast<std::size_t>(BotPhase::Playing)], botCount,
+              totals.byPhase[static_cast<std::size_t>(BotPhase::Failed)], formatMs(totals.move.percentile(50)).c_str(),
+              formatMs(totals.move.percentile(95)).c_str(), formatMs(totals.move.percentile(99)).c_str(),
+              static_cast<unsigned long long>(totals.move.count()), formatMs(totals.attack.percentile(50)).c_str(),
+              formatMs(totals.attack.percentile(95)).c_str(), formatMs(totals.join.percentile(50)).c_str());
+}
+
+void printPerBot(const std::vector<BotStats>& stats, double seconds) {
+  std::printf("%5s %-10s %9s %9s %8s %7s %7s %7s %7s %7s %7s  %s\n", "bot", "phase", "in/s", "KiB/s", "out/s",
+              "auth", "join", "mv p50", "mv p95", "mv max", "atk p50", "status");
+  for (std::size_t i = 0; i < stats.size(); ++i) {
+    const BotStats& s = stats[i];
+    std::printf("%5zu %-10s %9.1f %9.1f %8.1f %7s %7s %7s %7s %7s %7s  %s\n", i, phaseName(s.phase),
+                static_cast<double>(s.msgsIn) / seconds, static_cast<double>(s.bytesIn) / 1024.0 / seconds,
+                static_cast<double>(s.msgsOut) / seconds, formatMs(s.authMs).c_str(), formatMs(s.joinMs).c_str(),
+                formatMs(s.move.percentile(50)).c_str(), formatMs(s.move.percentile(95)).c_str(),
+                formatMs(s.move.count() > 0 ? s.move.maxMs() : -1.0).c_str(),
+                formatMs(s.attack.percentile(50)).c_str(), s.status.c_str());
+  }
+}
+}  // namespace
+
+int runBotSwarm(const BotSwarmOptions& options) {
+  if (options.bots <= 0) {
+    return 0;
+  }
+  const int threads = options.threads > 0
+                          ? options.threads
+                          : static_cast<int>(std::clamp(std::thread::hardware_concurrency(), 1u, 4u));
+
+  Endpoint endpoint;
+  endpoint.clear_access_channels(websocketpp::log::alevel::all);
+  endpoint.clear_error_channels(websocketpp::log::elevel::all);
+  endpoint.init_asio();
+  endpoint.start_perpetual();
+
+  std::vector<std::unique_ptr<Bot>> bots;
+  bots.reserve(static_cast<std::size_t>(options.bots));
+  for (int i = 0; i < options.bots; ++i) {
+    bots.push_back(std::make_unique<Bot>(i, endpoint, options));
+  }
+
+  std::vector<std::thread> pool;
+  for (int i = 0; i < threads; ++i) {
+    pool.emplace_back([&endpoint] { endpoint.run(); });
+  }
+
+  // httplib is blocking, so auth gets its own workers rather than stalling
+  // the shared io threads while later bots are still logging in.
+  std::atomic<bool> stopping{false};
+  std::atomic<std::size_t> nextAuth{0};
+  std::vector<std::thread> authWorkers;
+  for (int i = 0; i < threads; ++i) {
+    authWorkers.emplace_back([&] {
+      for (std::size_t n = nextAuth++; n < bots.size() && !stopping.load(); n = nextAuth++) {
+        Bot* bot = bots[n].get();
+        if (bot->authenticate()) {
+          websocketpp::lib::asio::post(endpoint.get_io_service(), [bot] { bot->connect(); });
+        }
+      }
+    });
+  }
+
+  std::printf("[bots] %d bots on %d io threads against %s\n", options.bots, threads, options.wsUrl.c_str());
+  std::signal(SIGINT, onInterrupt);
+  const auto started = Clock::now();
+  auto nextReport = started + std::chrono::seconds(kReportEverySec);
+  SwarmTotals previous;
+  while (!gInterrupted.load() &&
+         (options.durationSec <= 0 || Clock::now() - started < std::chrono::seconds(options.durationSec))) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (Clock::now() < nextReport) {
+      continue;
+    }
+    nextReport += std::chrono::seconds(kReportEverySec);
+    const SwarmTotals totals = collect(snapshotAll(bots));
+    char label[96];
+    std::snprintf(label, sizeof(label), "t=%.0fs in=%.0f msg/s %.1f KiB/s out=%.0f msg/s", msSince(started) / 1000.0,
+                  static_cast<double>(totals.msgsIn - previous.msgsIn) / kReportEverySec,
+                  static_cast<double>(totals.bytesIn - previous.bytesIn) / 1024.0 / kReportEverySec,
+                  static_cast<double>(totals.msgsOut - previous.msgsOut) / kReportEverySec);
+    printAggregate(label, totals, bots.size());
+    previous = totals;
+  }
+  const double seconds = std::max(0.001, msSince(started) / 1000.0);
+
+  stopping.store(true);
+  for (std::thread& worker : authWorkers) {
+    worker.join();
+  }
+  const std::vector<BotStats> finalStats = snapshotAll(bots);
+  for (const auto& bot : bots) {
+    websocketpp::lib::asio::post(endpoint.get_io_service(), [raw = bot.get()] { raw->stop(); });
+  }
+  // Give close frames a moment to go out before tearing the pool down.
+  endpoint.stop_perpetual();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  endpoint.stop();
+  for (std::thread& worker : pool) {
+    worker.join();
+  }
+
+  printPerBot(finalStats, seconds);
+  const SwarmTotals totals = collect(finalStats);
+  char label[96];
+  std::snprintf(label, sizeof(label), "total %.0fs in=%.0f msg/s %.1f KiB/s out=%.0f msg/s", seconds,
+                static_cast<double>(totals.msgsIn) / seconds, static_cast<double>(totals.bytesIn) / 1024.0 / seconds,
+                static_cast<double>(totals.msgsOut) / seconds);
+  printAggregate(label, totals, bots.size());
+  return totals.byPhase[static_cast<std::size_t>(BotPhase::Failed)] == bots.size() ? 1 : 0;
+}
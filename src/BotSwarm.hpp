@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+// Headless load generator behind `--bots N`. Every bot logs in, picks (or
+// creates) a character, joins the world, then wanders and attacks nearby
+// mobs. All world sockets share one websocketpp endpoint whose io_service is
+// run by a small thread pool; HTTP auth runs on the same number of workers.
+struct BotSwarmOptions {
+  std::string httpUrl;
+  std::string wsUrl;
+  int bots = 0;
+  int threads = 0;            // io threads; 0 = min(4, hardware threads)
+  int durationSec = 60;       // 0 = until interrupted
+  int moveIntervalMs = 250;
+  int attackIntervalMs = 1500;
+};
+
+// Blocks until the run ends, printing aggregate stats every few seconds and a
+// per-bot table at the end. Returns a process exit code.
+int runBotSwarm(const BotSwarmOptions& options);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+#include "NetworkConditioner.hpp"
+
+// Command-line / environment settings that are not persisted in settings.json.
+struct ClientOptions {
+  NetworkConditions net;
+  std::string recordPath;   // capture the world stream to this file
+  std::string replayPath;   // play a capture instead of connecting
+  double replaySpeed = 1.0;  // playback rate; 0 = as fast as possible
+};
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <array>
 #include <cctype>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -22,6 +23,8 @@
 #include <unistd.h>
 #endif
 
+#include "SessionStore.hpp"
+#include "WorldProtocol.hpp"
 #include "nlohmann/json.hpp"
 
 using json = nlohmann::json;
@@ -29,6 +32,33 @@ using json = nlohmann::json;
 namespace {
 constexpr float kMinZoom = 0.25f;
 constexpr float kMaxZoom = 1.0f;
+constexpr std::uint64_t kResyncRetryMs = 2000;
+// Update rate requested for entities in the interest margin outside the view.
+constexpr int kOuterRingRateHz = 4;
+// A socket opened during character selection is closed if unused this long.
+constexpr std::uint64_t kPreconnectIdleMs = 30000;
+// A stored token this close to its `exp` is not worth a validation request.
+constexpr std::int64_t kSessionExpiryMarginSec = 60;
+// Recent HTTP requests listed in the F3 overlay.
+constexpr std::size_t kHttpTimingRows = 3;
+
+std::uint64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+std::string formatKb(std::uint64_t bytes) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.1fK", static_cast<double>(bytes) / 1024.0);
+  return buf;
+}
+
+std::string formatHttpTiming(const HttpTiming& t) {
+  char buf[192];
+  std::snprintf(buf, sizeof(buf), "%s %s %d %s  dns %.1f  conn %.1f  ttfb %.1f  total %.1f ms", t.method.c_str(),
+                t.path.c_str(), t.status, t.reused ? "reused" : "new", t.dnsMs, t.connectMs, t.ttfbMs, t.totalMs);
+  return buf;
+}
 
 struct ClassArchetype {
   const char* name;
@@ -80,172 +110,29 @@ bool containsPoint(const sf::FloatRect& rect, sf::Vector2f point) {
   return rect.contains(point);
 }
 
-std::filesystem::path settingsFilePath() {
+// `name` next to the executable (cwd as a fallback).
+std::filesystem::path appFilePath(const char* name) {
 #if defined(_WIN32)
   char buffer[MAX_PATH];
   const DWORD len = GetModuleFileNameA(nullptr, buffer, MAX_PATH);
   if (len > 0 && len < MAX_PATH) {
-    return std::filesystem::path(buffer).parent_path() / "settings.json";
+    return std::filesystem::path(buffer).parent_path() / name;
   }
 #elif defined(__APPLE__)
   char buffer[PATH_MAX];
   uint32_t size = sizeof(buffer);
   if (_NSGetExecutablePath(buffer, &size) == 0) {
-    return std::filesystem::path(buffer).parent_path() / "settings.json";
+    return std::filesystem::path(buffer).parent_path() / name;
   }
 #else
   char buffer[4096];
   const ssize_t len = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
   if (len > 0) {
     buffer[len] = '\0';
-    return std::filesystem::path(buffer).parent_path() / "settings.json";
+    return std::filesystem::path(buffer).parent_path() / name;
   }
 #endif
-  return std::filesystem::current_path() / "settings.json";
-}
-
-std::optional<std::string> getStringField(const json& j, std::initializer_list<const char*> keys) {
-  for (const char* key : keys) {
-    if (j.contains(key) && j[key].is_string()) {
-      return j[key].get<std::string>();
-    }
-  }
-  return std::nullopt;
-}
-
-std::optional<int> getIntField(const json& j, std::initializer_list<const char*> keys) {
-  for (const char* key : keys) {
-    if (!j.contains(key)) {
-      continue;
-    }
-    const auto& v = j[key];
-    if (v.is_number_integer()) {
-      return v.get<int>();
-    }
-    if (v.is_number_float()) {
-      return static_cast<int>(std::round(v.get<float>()));
-    }
-    if (v.is_string()) {
-      try {
-        return std::stoi(v.get<std::string>());
-      } catch (...) {
-      }
-    }
-  }
-  return std::nullopt;
-}
-
-std::pair<int, int> parsePosition2D(const json& j) {
-  if (j.contains("position") && j["position"].is_object()) {
-    const auto& p = j["position"];
-    const int x = getIntField(p, {"x", "tileX", "col"}).value_or(0);
-    const int y = getIntField(p, {"y", "tileY", "row"}).value_or(0);
-    return {x, y};
-  }
-  const int x = getIntField(j, {"x", "tileX", "col"}).value_or(0);
-  const int y = getIntField(j, {"y", "tileY", "row"}).value_or(0);
-  return {x, y};
-}
-
-TileType parseTileType(const json& node) {
-  if (node.is_string()) {
-    std::string s = node.get<std::string>();
-    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-    if (s == "grass" || s == "g") {
-      return TileType::Grass;
-    }
-    if (s == "water" || s == "w") {
-      return TileType::Water;
-    }
-    if (s == "wall" || s == "#") {
-      return TileType::Wall;
-    }
-    if (s == "forest" || s == "f") {
-      return TileType::Forest;
-    }
-  } else if (node.is_number_integer()) {
-    switch (node.get<int>()) {
-      case 1:
-        return TileType::Water;
-      case 2:
-        return TileType::Wall;
-      case 3:
-        return TileType::Forest;
-      default:
-        return TileType::Grass;
-    }
-  }
-  return TileType::Grass;
-}
-
-PlayerState parsePlayer(const json& j) {
-  PlayerState p;
-  p.id = getStringField(j, {"id", "playerId", "userId", "username", "name"}).value_or("");
-  p.name = getStringField(j, {"name", "username", "displayName"}).value_or(p.id);
-  p.className = getStringField(j, {"class", "character", "job"}).value_or("Unknown");
-  p.level = getIntField(j, {"level"}).value_or(1);
-  p.experience = getIntField(j, {"experience", "xp"}).value_or(0);
-  p.hp = getIntField(j, {"hp", "health"}).value_or(100);
-  p.maxHp = std::max(1, getIntField(j, {"maxHP", "maxHp", "hpMax", "maxHealth"}).value_or(100));
-  p.alive = p.hp > 0;
-  const auto [x, y] = parsePosition2D(j);
-  p.x = x;
-  p.y = y;
-  p.renderX = static_cast<float>(x);
-  p.renderY = static_cast<float>(y);
-  return p;
-}
-
-NpcState parseNpc(const json& j) {
-  NpcState n;
-  n.id = getStringField(j, {"id", "npcId", "name"}).value_or("");
-  n.name = getStringField(j, {"name"}).value_or(n.id);
-  n.role = getStringField(j, {"role", "npc_role"}).value_or("");
-  n.portrait = getStringField(j, {"portrait", "npc_portrait"}).value_or("");
-  const auto [x, y] = parsePosition2D(j);
-  n.x = x;
-  n.y = y;
-  n.renderX = static_cast<float>(x);
-  n.renderY = static_cast<float>(y);
-  return n;
-}
-
-std::vector<DialogResponseState> parseDialogResponses(const json& node) {
-  std::vector<DialogResponseState> responses;
-  if (!node.contains("responses") || !node["responses"].is_array()) {
-    return responses;
-  }
-  responses.reserve(node["responses"].size());
-  for (const auto& entry : node["responses"]) {
-    if (!entry.is_object()) {
-      continue;
-    }
-    DialogResponseState resp;
-    resp.id = getStringField(entry, {"id"}).value_or("");
-    resp.text = getStringField(entry, {"text", "label", "name"}).value_or("");
-    resp.nextNodeId = getStringField(entry, {"next_node_id", "nextNodeId"}).value_or("");
-    resp.questTrigger = getStringField(entry, {"quest_trigger", "questTrigger"}).value_or("");
-    if (!resp.id.empty() && !resp.text.empty()) {
-      responses.push_back(resp);
-    }
-  }
-  return responses;
-}
-
-MobState parseMob(const json& j) {
-  MobState m;
-  m.id = getStringField(j, {"id", "mobId", "name"}).value_or("");
-  m.name = getStringField(j, {"name", "type"}).value_or(m.id);
-  m.hp = getIntField(j, {"hp", "health"}).value_or(100);
-  m.maxHp = std::max(1, getIntField(j, {"maxHP", "maxHp", "hpMax", "maxHealth"}).value_or(100));
-  m.alive = m.hp > 0;
-  m.aggressive = j.value("aggressive", j.value("isAggro", false));
-  const auto [x, y] = parsePosition2D(j);
-  m.x = x;
-  m.y = y;
-  m.renderX = static_cast<float>(x);
-  m.renderY = static_cast<float>(y);
-  return m;
+  return std::filesystem::current_path() / name;
 }
 
 template <typename T>
@@ -261,40 +148,118 @@ void upsertEntity(std::unordered_map<std::string, T>& map, const T& incoming) {
   it->second = next;
 }
 
-void parseTiles(WorldSnapshot& data, const json& mapNode) {
-  const int width = getIntField(mapNode, {"width", "w"}).value_or(data.width);
-  const int height = getIntField(mapNode, {"height", "h"}).value_or(data.height);
-  if (width <= 0 || height <= 0) {
-    return;
+void applyTileMap(WorldSnapshot& data, TileMap& map) {
+  data.width = map.width;
+  data.height = map.height;
+  data.tiles = std::move(map.tiles);
+}
+
+void pushChatLine(WorldSnapshot& data, std::string text) {
+  data.chatLines.push_back(ChatLine{std::move(text), WorldState::nowMs()});
+  while (data.chatLines.size() > 12) {
+    data.chatLines.pop_front();
   }
-  data.width = width;
-  data.height = height;
-  data.tiles.assign(static_cast<std::size_t>(width * height), TileType::Grass);
+}
 
-  if (!mapNode.contains("tiles") || !mapNode["tiles"].is_array()) {
+// Same walkability rule the server applies to a `move`.
+void applyPredictedStep(const WorldSnapshot& data, PlayerState& self, int dx, int dy) {
+  const int nx = self.x + dx;
+  const int ny = self.y + dy;
+  if (nx < 0 || ny < 0 || nx >= data.width || ny >= data.height) {
     return;
   }
-  const auto& rows = mapNode["tiles"];
-  for (int y = 0; y < std::min(height, static_cast<int>(rows.size())); ++y) {
-    const auto& row = rows[static_cast<std::size_t>(y)];
-    if (row.is_string()) {
-      const std::string s = row.get<std::string>();
-      for (int x = 0; x < std::min(width, static_cast<int>(s.size())); ++x) {
-        data.tiles[static_cast<std::size_t>(y * width + x)] = parseTileType(std::string(1, s[static_cast<std::size_t>(x)]));
-      }
-      continue;
-    }
-    if (!row.is_array()) {
-      continue;
-    }
-    for (int x = 0; x < std::min(width, static_cast<int>(row.size())); ++x) {
-      data.tiles[static_cast<std::size_t>(y * width + x)] = parseTileType(row[static_cast<std::size_t>(x)]);
-    }
+  const TileType tile = data.tiles[static_cast<std::size_t>(ny * data.width + nx)];
+  if (tile != TileType::Wall && tile != TileType::Water) {
+    self.x = nx;
+    self.y = ny;
+  }
+}
+
+void applyDeltaFields(PlayerState& p, const EntityDelta& d) {
+  if (d.mask & DeltaField::kX) {
+    p.x = d.x;
+  }
+  if (d.mask & DeltaField::kY) {
+    p.y = d.y;
+  }
+  if (d.mask & DeltaField::kHp) {
+    p.hp = d.hp;
+    p.alive = p.hp > 0;
+  }
+  if (d.mask & DeltaField::kMaxHp) {
+    p.maxHp = std::max(1, d.maxHp);
+  }
+  if (d.mask & DeltaField::kAlive) {
+    p.alive = d.alive;
+  }
+  if (d.mask & DeltaField::kLevel) {
+    p.level = d.level;
+  }
+  if (d.mask & DeltaField::kExperience) {
+    p.experience = d.experience;
+  }
+  if (d.mask & DeltaField::kName) {
+    p.name = d.name;
+  }
+  if (d.mask & DeltaField::kClass) {
+    p.className = d.className;
+  }
+}
+
+void applyDeltaFields(MobState& m, const EntityDelta& d) {
+  if (d.mask & DeltaField::kX) {
+    m.x = d.x;
+  }
+  if (d.mask & DeltaField::kY) {
+    m.y = d.y;
+  }
+  if (d.mask & DeltaField::kHp) {
+    m.hp = d.hp;
+    m.alive = m.hp > 0;
+  }
+  if (d.mask & DeltaField::kMaxHp) {
+    m.maxHp = std::max(1, d.maxHp);
+  }
+  if (d.mask & DeltaField::kAlive) {
+    m.alive = d.alive;
+  }
+  if (d.mask & DeltaField::kName) {
+    m.name = d.name;
+  }
+  if (d.mask & DeltaField::kAggressive) {
+    m.aggressive = d.aggressive;
+  }
+}
+
+// Finds the entity a delta targets. Unknown ids are created only when the
+// delta carries a full position; otherwise the baseline is missing.
+template <typename T>
+T* deltaTarget(std::unordered_map<std::string, T>& map, const EntityDelta& d) {
+  auto it = map.find(d.id);
+  if (it != map.end()) {
+    return &it->second;
+  }
+  if ((d.mask & DeltaField::kPosition) != DeltaField::kPosition) {
+    return nullptr;
+  }
+  T& entity = map[d.id];
+  entity.id = d.id;
+  entity.name = d.id;
+  entity.renderX = static_cast<float>(d.x);
+  entity.renderY = static_cast<float>(d.y);
+  return &entity;
+}
+
+template <typename T>
+void replaceEntities(std::unordered_map<std::string, T>& map, std::vector<T>& incoming) {
+  map.clear();
+  for (auto& entity : incoming) {
+    upsertEntity(map, entity);
   }
 }
 }  // namespace
 
-GameClient::GameClient(std::string httpUrl, std::string wsUrl)
+GameClient::GameClient(std::string httpUrl, std::string wsUrl, const ClientOptions& options)
     : window_(sf::VideoMode(1920, 1080), "MMORPG SFML Client"), authClient_(std::move(httpUrl)),
       wsUrl_(std::move(wsUrl)) {
   window_.setVerticalSyncEnabled(false);
@@ -332,6 +297,30 @@ GameClient::GameClient(std::string httpUrl, std::string wsUrl)
 
   renderer_.initGL();
   loadSettings();
+  wsClient_.setDecodeOnNetworkThread(decodeOnNetworkThread_);
+  wsClient_.setAutoReconnect(reconnectEnabled_);
+  wsClient_.setHeartbeat(heartbeat_);
+  wsClient_.setCompressionEnabled(wsCompression_);
+  if (options.net.active()) {
+    wsClient_.setNetworkConditions(options.net);
+    std::printf("[client] network conditioner: %s\n", options.net.describe().c_str());
+  }
+  if (!options.recordPath.empty()) {
+    auto recorder = std::make_shared<SessionRecorder>();
+    if (recorder->open(options.recordPath)) {
+      wsClient_.setRecorder(recorder);
+      std::printf("[client] recording world stream to %s\n", options.recordPath.c_str());
+    } else {
+      std::fprintf(stderr, "[client] cannot record to %s\n", options.recordPath.c_str());
+    }
+  }
+  if (!options.replayPath.empty()) {
+    replayPath_ = options.replayPath;
+    replaySpeed_ = options.replaySpeed;
+    startReplaySession();
+  } else {
+    resumeStoredSession();
+  }
   renderer_.resize(static_cast<int>(window_.getSize().x), static_cast<int>(window_.getSize().y));
   settingsZoom_ = renderer_.cameraZoom();
   updateSettingsLayout();
@@ -465,7 +454,7 @@ void GameClient::handleSettingsMouseReleased() {
 void GameClient::loadSettings() {
   settingsZoom_ = renderer_.cameraZoom();
 
-  const std::filesystem::path path = settingsFilePath();
+  const std::filesystem::path path = appFilePath("settings.json");
   std::ifstream in(path);
   if (!in.is_open()) {
     return;
@@ -493,6 +482,25 @@ void GameClient::loadSettings() {
   window_.setSize(sf::Vector2u(viewportWidth, viewportHeight));
   renderer_.resize(static_cast<int>(viewportWidth), static_cast<int>(viewportHeight));
 
+  if (config.contains("decode_on_network_thread") && config["decode_on_network_thread"].is_boolean()) {
+    decodeOnNetworkThread_ = config["decode_on_network_thread"].get<bool>();
+  }
+  if (config.contains("binary_encoding") && config["binary_encoding"].is_boolean()) {
+    binaryEncoding_ = config["binary_encoding"].get<bool>();
+  }
+  if (config.contains("ws_compression") && config["ws_compression"].is_boolean()) {
+    wsCompression_ = config["ws_compression"].get<bool>();
+  }
+  if (auto delay = getIntField(config, {"interp_delay_ms"})) {
+    interpDelayMs_ = std::clamp(*delay, 0, 1000);
+  }
+  if (auto interval = getIntField(config, {"heartbeat_interval_ms"})) {
+    heartbeat_.intervalMs = std::clamp(*interval, 250, 60000);
+  }
+  if (auto timeout = getIntField(config, {"heartbeat_timeout_ms"})) {
+    heartbeat_.pongTimeoutMs = std::clamp(*timeout, 100, 60000);
+  }
+
   if (config.contains("camera_zoom")) {
     const auto& zoom = config["camera_zoom"];
     if (zoom.is_number()) {
@@ -507,9 +515,15 @@ void GameClient::saveSettings() const {
   const json config{
       {"viewport", {{"width", viewport.x}, {"height", viewport.y}}},
       {"camera_zoom", renderer_.cameraZoom()},
+      {"decode_on_network_thread", decodeOnNetworkThread_},
+      {"ws_compression", wsCompression_},
+      {"binary_encoding", binaryEncoding_},
+      {"interp_delay_ms", interpDelayMs_},
+      {"heartbeat_interval_ms", heartbeat_.intervalMs},
+      {"heartbeat_timeout_ms", heartbeat_.pongTimeoutMs},
   };
 
-  std::ofstream out(settingsFilePath(), std::ios::trunc);
+  std::ofstream out(appFilePath("settings.json"), std::ios::trunc);
   if (!out.is_open()) {
     return;
   }
@@ -525,6 +539,10 @@ void GameClient::handleAuthEvent(const sf::Event& event) {
       statusText_ = (authMode_ == AuthMode::Login) ? "Mode: Login" : "Mode: Register";
     } else if (event.key.code == sf::Keyboard::Enter) {
       submitAuth();
+    } else if (event.key.code == sf::Keyboard::Escape && httpBusy()) {
+      cancelHttpRequests();
+      dropPreconnect();
+      statusText_ = "Sign-in canceled";
     } else if (event.key.code == sf::Keyboard::BackSpace) {
       std::string& field = (authField_ == AuthField::Username) ? username_ : password_;
       if (!field.empty()) {
@@ -562,6 +580,11 @@ void GameClient::handleCharacterSelectEvent(const sf::Event& event) {
     selectedCharacterId_ = characters_[selectedCharacterIndex_].id;
     startWorldSession();
   } else if (event.key.code == sf::Keyboard::Escape) {
+    // Signing out: the next launch should not skip the login either.
+    cancelHttpRequests();
+    dropPreconnect();
+    clearSession(appFilePath("session.json"));
+    jwt_.clear();
     screen_ = ScreenState::Auth;
     statusText_ = "Back to login";
   }
@@ -583,18 +606,14 @@ void GameClient::handleCharacterCreateEvent(const sf::Event& event) {
         statusText_ = "Character name is required";
         return;
       }
-      const std::string className = kClassArchetypes[createClassIndex_].name;
-      auto createdOpt = authClient_.createCharacter(jwt_, finalName, className);
-      if (createdOpt) {
-        characters_.push_back(*createdOpt);
-        selectedCharacterIndex_ = characters_.size() - 1;
-        selectedCharacterId_ = createdOpt->id;
-        statusText_ = "Character created on server. Press Enter to join.";
-      } else {
-        statusText_ = "Failed to create character on server. Try again.";
+      if (httpBusy()) {
+        return;
       }
-      screen_ = ScreenState::CharacterSelect;
+      const std::string className = kClassArchetypes[createClassIndex_].name;
+      createRequest_ = authClient_.createCharacterAsync(jwt_, finalName, className);
+      beginHttpProgress("Creating character");
     } else if (event.key.code == sf::Keyboard::Escape) {
+      cancelHttpRequests();
       statusText_ = "Character creation canceled";
       screen_ = ScreenState::CharacterSelect;
     }
@@ -616,6 +635,10 @@ void GameClient::handleWorldEvent(const sf::Event& event) {
   }();
 
   if (event.type == sf::Event::KeyPressed) {
+    if (event.key.code == sf::Keyboard::F3) {
+      telemetryOverlay_ = !telemetryOverlay_;
+      return;
+    }
     if (event.key.code == sf::Keyboard::F10) {
       settingsMenuOpen_ = !settingsMenuOpen_;
       draggingZoomSlider_ = false;
@@ -682,35 +705,191 @@ void GameClient::handleWorldEvent(const sf::Event& event) {
 }
 
 void GameClient::submitAuth() {
+  if (httpBusy()) {
+    return;
+  }
   if (username_.empty() || password_.empty()) {
     statusText_ = "Username and password are required";
     return;
   }
-  const AuthResult result = (authMode_ == AuthMode::Login)
-                                ? authClient_.login(username_, password_)
-                                : authClient_.reg(username_, password_);
-  if (!result.ok) {
-    statusText_ = result.message;
+  authRequest_ = (authMode_ == AuthMode::Login) ? authClient_.loginAsync(username_, password_)
+                                                : authClient_.regAsync(username_, password_);
+  beginHttpProgress(authMode_ == AuthMode::Login ? "Signing in" : "Registering");
+}
+
+bool GameClient::httpBusy() const {
+  return authRequest_.active() || charactersRequest_.active() || createRequest_.active();
+}
+
+void GameClient::beginHttpProgress(const std::string& label) {
+  httpLabel_ = label;
+  httpStartedAtMs_ = WorldState::nowMs();
+  statusText_ = label + "...";
+}
+
+void GameClient::cancelHttpRequests() {
+  resumingSession_ = false;
+  showingCachedCharacters_ = false;
+  authRequest_.cancel();
+  charactersRequest_.cancel();
+  createRequest_.cancel();
+}
+
+// Requests run on HttpAuthClient's workers; results are applied here, on the
+// frame loop, so screen state is only ever touched by this thread.
+void GameClient::pollHttpRequests() {
+  for (HttpTiming& t : authClient_.takeTimings()) {
+    if (httpTimings_.size() >= kHttpTimingRows) {
+      httpTimings_.pop_front();
+    }
+    httpTimings_.push_back(std::move(t));
+  }
+  if (authRequest_.ready()) {
+    const AuthResult result = authRequest_.take();
+    if (!result.ok) {
+      statusText_ = result.message;
+      return;
+    }
+    jwt_ = result.token;
+    if (!saveSession(appFilePath("session.json"), StoredSession{jwt_, username_, jwtExpiry(jwt_)})) {
+      std::fprintf(stderr, "[client] could not store session token\n");
+    }
+    requestCharacters("Loading characters");
+    preconnectWorld();
+  }
+  if (charactersRequest_.ready()) {
+    CharacterList list = charactersRequest_.take();
+    const bool resumed = resumingSession_;
+    const bool cachedShown = showingCachedCharacters_;
+    resumingSession_ = false;
+    showingCachedCharacters_ = false;
+    if (list.status == 401 || (resumed && !cachedShown && list.status != 200)) {
+      dropPreconnect();
+      jwt_.clear();
+      if (list.status == 401) {
+        clearSession(appFilePath("session.json"));
+      }
+      statusText_ = list.status == 401 ? "Session expired, please log in" : "Could not resume session, please log in";
+      screen_ = ScreenState::Auth;
+      return;
+    }
+    if (list.status == 200) {
+      saveCachedCharacters(appFilePath("characters_cache.json"), username_, list);
+      // A refresh behind the cached list only lands while it is on screen; the
+      // player may already be creating a character or in the world.
+      if (!cachedShown || (screen_ == ScreenState::CharacterSelect && !createRequest_.active())) {
+        showCharacters(std::move(list.items));
+      }
+    } else if (cachedShown && list.status != 304) {
+      statusText_ = "Could not refresh characters, showing saved list";
+    } else if (!cachedShown) {
+      showCharacters({});
+    }
+  }
+  if (createRequest_.ready()) {
+    const std::optional<CharacterInfo> created = createRequest_.take();
+    if (created) {
+      characters_.push_back(*created);
+      // No validators: the next login fetches the list in full.
+      saveCachedCharacters(appFilePath("characters_cache.json"), username_, CharacterList{200, characters_, {}, {}});
+      selectedCharacterIndex_ = characters_.size() - 1;
+      selectedCharacterId_ = created->id;
+      statusText_ = "Character created on server. Press Enter to join.";
+    } else {
+      statusText_ = "Failed to create character on server. Try again.";
+    }
+    screen_ = ScreenState::CharacterSelect;
+  }
+  if (httpBusy() && !httpLabel_.empty()) {
+    char progress[96];
+    std::snprintf(progress, sizeof(progress), "%s... %.1fs  (Esc to cancel)", httpLabel_.c_str(),
+                  static_cast<double>(WorldState::nowMs() - httpStartedAtMs_) / 1000.0);
+    statusText_ = progress;
+  }
+}
+
+// Validates the token saved by the last login with the character fetch, which
+// the character select screen needs anyway; a 401 falls back to the login.
+void GameClient::resumeStoredSession() {
+  const std::filesystem::path path = appFilePath("session.json");
+  const std::optional<StoredSession> stored = loadSession(path);
+  if (!stored) {
     return;
   }
-  jwt_ = result.token;
-  
-  // Fetch characters from server
-  characters_ = authClient_.fetchCharacters(jwt_);
+  if (stored->expired(kSessionExpiryMarginSec)) {
+    clearSession(path);
+    statusText_ = "Session expired, please log in";
+    return;
+  }
+  jwt_ = stored->token;
+  username_ = stored->username;
+  resumingSession_ = true;
+  requestCharacters("Resuming session");
+  preconnectWorld();
+}
+
+// With a cached list for this user the select screen opens at once and a
+// conditional GET revalidates it in the background; otherwise the player
+// waits on the fetch.
+void GameClient::requestCharacters(const std::string& progressLabel) {
+  const std::optional<CharacterList> cached = loadCachedCharacters(appFilePath("characters_cache.json"), username_);
+  if (!cached) {
+    charactersRequest_ = authClient_.fetchCharactersAsync(jwt_);
+    beginHttpProgress(progressLabel);
+    return;
+  }
+  showCharacters(cached->items);
+  showingCachedCharacters_ = true;
+  charactersRequest_ = authClient_.fetchCharactersAsync(jwt_, cached->etag, cached->lastModified);
+  httpLabel_.clear();  // no progress line over the select screen
+}
+
+void GameClient::showCharacters(std::vector<CharacterInfo> characters) {
+  characters_ = std::move(characters);
   selectedCharacterIndex_ = 0;
-  selectedCharacterId_ = characters_.empty() ? "" : characters_[0].id;
+  for (std::size_t i = 0; i < characters_.size(); ++i) {
+    if (characters_[i].id == selectedCharacterId_) {
+      selectedCharacterIndex_ = i;  // keep the selection across a refresh
+      break;
+    }
+  }
+  selectedCharacterId_ = characters_.empty() ? "" : characters_[selectedCharacterIndex_].id;
   statusText_ = characters_.empty() ? "No characters found. Create your first character."
                                     : "Select character or create a new one";
   screen_ = ScreenState::CharacterSelect;
 }
 
+void GameClient::preconnectWorld() {
+  if (jwt_.empty() || !replayPath_.empty()) {
+    return;
+  }
+  // Handshake while the player is still choosing; join binds the character.
+  if (wsClient_.connect(wsUrl_, jwt_)) {
+    preconnectStartedAtMs_ = WorldState::nowMs();
+    std::printf("[client] pre-connecting to %s\n", wsUrl_.c_str());
+  }
+}
+
+void GameClient::dropPreconnect() {
+  if (preconnectStartedAtMs_ == 0) {
+    return;
+  }
+  preconnectStartedAtMs_ = 0;
+  wsClient_.disconnect();
+}
+
 void GameClient::startWorldSession() {
   if (characters_.empty() || selectedCharacterIndex_ >= characters_.size()) {
     statusText_ = "Select a character first";
     screen_ = ScreenState::CharacterSelect;
     return;
   }
-  leaveWorldSession();
+  // Reuse the socket opened after login if it is still up or retrying.
+  const bool preconnected = preconnectStartedAtMs_ != 0 && wsClient_.state() != ConnectionState::Idle;
+  preconnectStartedAtMs_ = 0;
+  if (!preconnected) {
+    leaveWorldSession();
+  }
 
   const CharacterInfo& selected = characters_[selectedCharacterIndex_];
   
@@ -725,41 +904,149 @@ void GameClient::startWorldSession() {
     world_.data.players[self.id] = self;
   }
 
-  joinSent_ = false;
-  moveAccumulator_ = 0.0f;
-  reconnectAccumulator_ = 0.0f;
-  lastMoveAtMs_ = 0;
-  lastAttackAtMs_ = 0;
-  lastInteractAtMs_ = 0;
-  if (!wsClient_.connect(wsUrl_, jwt_)) {
+  resetSessionState();
+  if (preconnected) {
+    std::printf("[client] joining over pre-connected socket (%s)\n", wsClient_.lastStatus().c_str());
+  } else if (!wsClient_.connect(wsUrl_, jwt_)) {
     statusText_ = wsClient_.lastStatus();
     world_.setConnectionStatus(statusText_, false);
     return;
+  } else {
+    std::printf("[client] connecting to %s\n", wsUrl_.c_str());
   }
-  std::printf("[client] connecting to %s\n", wsUrl_.c_str());
   statusText_ = "Connecting to world...";
   world_.setConnectionStatus(statusText_, false);
   screen_ = ScreenState::World;
 }
 
+void GameClient::resetSessionState() {
+  joinedConnectionId_ = 0;
+  moveAccumulator_ = 0.0f;
+  lastServerSeq_ = 0;
+  negotiatedEncoding_ = WireEncoding::Json;
+  telemetry_.reset();
+  wsClient_.resetInboundHighWater();
+  clockSync_.reset();
+  movePredictor_.clear();
+  playerHistory_.clear();
+  npcHistory_.clear();
+  mobHistory_.clear();
+  interest_.reset();
+  interest_.clearEvicted();
+  lastMoveAtMs_ = 0;
+  lastAttackAtMs_ = 0;
+  lastInteractAtMs_ = 0;
+}
+
+void GameClient::startReplaySession() {
+  replayer_ = std::make_unique<SessionReplayer>();
+  if (!replayer_->open(replayPath_)) {
+    statusText_ = "Replay failed: " + replayer_->error();
+    std::fprintf(stderr, "[client] %s\n", statusText_.c_str());
+    replayer_.reset();
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(world_.mutex);
+    world_.data = WorldSnapshot{};
+  }
+  resetSessionState();
+  replayClockUs_ = 0.0;
+  replayRecordPending_ = false;
+  replayInbound_ = 0;
+  replayOutbound_ = 0;
+  replayStartedAt_ = std::chrono::steady_clock::now();
+  replayBaseMs_ = WorldState::nowMs();
+  world_.setConnectionStatus("Replaying " + replayPath_, true);
+  screen_ = ScreenState::World;
+  std::printf("[client] replaying %s at %s\n", replayPath_.c_str(),
+              replaySpeed_ > 0.0 ? (std::to_string(replaySpeed_) + "x").c_str() : "max speed");
+}
+
+void GameClient::feedReplay(float dt) {
+  // At max speed, leave part of the frame for rendering so it stays observable.
+  constexpr auto kMaxSpeedBudget = std::chrono::milliseconds(12);
+  const auto frameStart = std::chrono::steady_clock::now();
+  replayClockUs_ += static_cast<double>(dt) * 1e6 * replaySpeed_;
+
+  for (;;) {
+    if (!replayRecordPending_) {
+      if (!replayer_->next(replayRecord_)) {
+        finishReplay();
+        return;
+      }
+      replayRecordPending_ = true;
+    }
+    if (replaySpeed_ > 0.0 && static_cast<double>(replayRecord_.timeUs) > replayClockUs_) {
+      return;
+    }
+    if (replaySpeed_ <= 0.0 && std::chrono::steady_clock::now() - frameStart > kMaxSpeedBudget) {
+      return;
+    }
+    replayRecordPending_ = false;
+    if (!replayRecord_.inbound()) {
+      ++replayOutbound_;
+      continue;
+    }
+    // Recorded arrival times keep interpolation and clock sync identical
+    // from run to run, whatever the playback speed.
+    parseAndApplyMessage(replayRecord_.payload, replayRecord_.binary(), replayBaseMs_ + replayRecord_.timeUs / 1000);
+    ++replayInbound_;
+  }
+}
+
+void GameClient::finishReplay() {
+  const double wallSec =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStartedAt_).count();
+  std::uint64_t decodeNs = 0;
+  std::uint64_t applyNs = 0;
+  for (const auto& [type, stats] : telemetry_.byType()) {
+    decodeNs += stats.decodeNs;
+    applyNs += stats.applyNs;
+  }
+  const std::string error = replayer_->error();
+  std::printf("[client] replay finished: %llu inbound, %llu outbound records in %.2fs; decode %.1fms, apply %.1fms%s%s%s\n",
+              static_cast<unsigned long long>(replayInbound_), static_cast<unsigned long long>(replayOutbound_),
+              wallSec, static_cast<double>(decodeNs) / 1e6, static_cast<double>(applyNs) / 1e6,
+              replayer_->truncatedTail() ? "; last record incomplete, ignored" : "",
+              error.empty() ? "" : "; stopped early: ", error.c_str());
+  world_.pushChat("Replay finished (" + std::to_string(replayInbound_) + " messages)");
+  world_.setConnectionStatus("Replay finished", false);
+  replayer_.reset();
+}
+
 void GameClient::leaveWorldSession() {
   wsClient_.disconnect();
-  joinSent_ = false;
-  reconnectAccumulator_ = 0.0f;
+  joinedConnectionId_ = 0;
   world_.setConnectionStatus("Disconnected", false);
 }
 
 void GameClient::update(float dt) {
+  pollHttpRequests();
   if (screen_ != ScreenState::World) {
+    if (preconnectStartedAtMs_ != 0 && WorldState::nowMs() - preconnectStartedAtMs_ > kPreconnectIdleMs) {
+      std::printf("[client] closing idle pre-connected world socket\n");
+      dropPreconnect();
+    }
+    return;
+  }
+
+  if (!replayPath_.empty()) {
+    if (replayer_) {
+      feedReplay(dt);
+    }
+    updateInterest();
+    updateInterpolations(dt);
+    updateCombatEffects(dt);
     return;
   }
 
   processNetworkMessages();
   sendJoinIfNeeded();
   updateMovement(dt);
+  updateInterest();
   updateInterpolations(dt);
   updateCombatEffects(dt);
-  maybeReconnect(dt);
 
   if (!wsClient_.isConnected()) {
     world_.setConnectionStatus(wsClient_.lastStatus(), false);
@@ -768,10 +1055,68 @@ void GameClient::update(float dt) {
   }
 }
 
+void GameClient::updateInterest() {
+  std::optional<TileRect> changed;
+  {
+    std::lock_guard<std::mutex> lock(world_.mutex);
+    auto& data = world_.data;
+    if (!data.worldReady) {
+      return;
+    }
+    const sf::IntRect tiles = renderer_.visibleTiles(data);
+    const TileRect visible{tiles.left, tiles.top, tiles.left + tiles.width - 1, tiles.top + tiles.height - 1};
+    changed = interest_.update(visible, data.width, data.height);
+    if (!interest_.active()) {
+      return;
+    }
+
+    // No-op until the server acknowledges: one that does not filter by area
+    // would never resend an evicted entity that stands still. Afterwards this
+    // catches entities whose last update moved them out; the rest arrive as
+    // `interest_leave`.
+    for (auto it = data.players.begin(); it != data.players.end();) {
+      if (it->first != data.localPlayerId && interest_.shouldEvict(it->second.x, it->second.y)) {
+        interest_.noteEvicted(it->first);
+        playerHistory_.erase(it->first);
+        it = data.players.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (auto it = data.mobs.begin(); it != data.mobs.end();) {
+      if (interest_.shouldEvict(it->second.x, it->second.y)) {
+        interest_.noteEvicted(it->first);
+        mobHistory_.erase(it->first);
+        it = data.mobs.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  if (!changed || !replayPath_.empty() || !wsClient_.isConnected()) {
+    return;
+  }
+  const TileRect& inner = interest_.inner();
+  json interestMsg{
+      {"type", "interest"},
+      {"x", changed->minX},
+      {"y", changed->minY},
+      {"w", changed->width()},
+      {"h", changed->height()},
+      {"inner", {{"x", inner.minX}, {"y", inner.minY}, {"w", inner.width()}, {"h", inner.height()}}},
+      {"outer_rate_hz", kOuterRingRateHz},
+  };
+  sendWorldMessage(interestMsg, "interest");
+}
+
 void GameClient::sendJoinIfNeeded() {
-  if (joinSent_ || !wsClient_.isConnected()) {
+  const std::uint32_t connectionId = wsClient_.connectionId();
+  if (connectionId == joinedConnectionId_ || !wsClient_.isConnected()) {
     return;
   }
+  // The socket reconnects on its own; a later join resumes the session.
+  const bool rejoin = joinedConnectionId_ != 0;
   const CharacterInfo& selected = characters_[selectedCharacterIndex_];
   json joinMsg{
       {"type", "join"},
@@ -779,11 +1124,33 @@ void GameClient::sendJoinIfNeeded() {
       {"name", selected.name},
       {"class", selected.className},
   };
-  wsClient_.sendText(joinMsg.dump());
-  joinSent_ = true;
+  if (binaryEncoding_) {
+    // The server answers with `encoding` in welcome; until then we speak JSON.
+    joinMsg["encodings"] = json::array({"msgpack", "cbor", "json"});
+  }
+  if (rejoin && lastServerSeq_ > 0) {
+    // Ask the server to replay what we missed instead of a full welcome.
+    joinMsg["last_seq"] = lastServerSeq_;
+  }
+  outboundEncoding_ = WireEncoding::Json;
+  sendWorldMessage(joinMsg);
+  joinedConnectionId_ = connectionId;
+  interest_.reset();  // the new connection has no subscription yet
+  if (rejoin) {
+    world_.pushChat("Reconnected to world socket");
+  }
   std::printf("[client] join sent for %s (id: %s)\n", selected.name.c_str(), selected.id.c_str());
 }
 
+bool GameClient::sendWorldMessage(const json& msg, const std::string& coalesceKey) {
+  const std::string payload = encodeWorldMessage(msg, outboundEncoding_);
+  if (!wsClient_.send(payload, outboundEncoding_ != WireEncoding::Json, coalesceKey)) {
+    return false;
+  }
+  telemetry_.recordOutbound(msg.value("type", ""), payload.size());
+  return true;
+}
+
 void GameClient::sendMoveCommand(int dx, int dy) {
   if ((dx == 0 && dy == 0) || !wsClient_.isConnected()) {
     return;
@@ -798,21 +1165,33 @@ void GameClient::sendMoveCommand(int dx, int dy) {
     std::lock_guard<std::mutex> lock(world_.mutex);
     auto selfIt = world_.data.players.find(world_.data.localPlayerId);
     if (selfIt != world_.data.players.end()) {
-      const int nx = selfIt->second.x + dx;
-      const int ny = selfIt->second.y + dy;
-      const bool valid = nx >= 0 && ny >= 0 && nx < world_.data.width && ny < world_.data.height;
-      if (valid) {
-        const TileType tile = world_.data.tiles[static_cast<std::size_t>(ny * world_.data.width + nx)];
-        if (tile != TileType::Wall && tile != TileType::Water) {
-          selfIt->second.x = nx;
-          selfIt->second.y = ny;
-        }
-      }
+      applyPredictedStep(world_.data, selfIt->second, dx, dy);
     }
   }
 
-  json moveMsg{{"type", "move"}, {"dx", dx}, {"dy", dy}};
-  wsClient_.sendText(moveMsg.dump());
+  // Moves are deltas, so they are never coalesced: each one is an input the
+  // server must see for reconciliation to line up.
+  const std::uint32_t seq = movePredictor_.record(dx, dy, now);
+  json moveMsg{{"type", "move"}, {"dx", dx}, {"dy", dy}, {"input_seq", seq}};
+  sendWorldMessage(moveMsg);
+}
+
+void GameClient::reconcileLocalPlayer(WorldSnapshot& data, PlayerState& self, std::uint32_t ackInputSeq) {
+  if (ackInputSeq > 0) {
+    movePredictor_.acknowledge(ackInputSeq);
+  } else {
+    const std::int64_t rttUs = wsClient_.smoothedRttUs();
+    const std::uint64_t rttMs = rttUs >= 0 ? static_cast<std::uint64_t>(rttUs / 1000) : 150;
+    const std::uint64_t now = WorldState::nowMs();
+    movePredictor_.acknowledgeSentBefore(now > rttMs ? now - rttMs : 0);
+  }
+  // `self` holds the authoritative position; renderX/Y were kept, so the
+  // correction is smoothed rather than snapped.
+  authoritativeSelfX_ = self.x;
+  authoritativeSelfY_ = self.y;
+  for (const auto& input : movePredictor_.pending()) {
+    applyPredictedStep(data, self, input.dx, input.dy);
+  }
 }
 
 void GameClient::updateMovement(float dt) {
@@ -846,20 +1225,37 @@ void GameClient::updateMovement(float dt) {
 }
 
 void GameClient::updateInterpolations(float dt) {
-  const float alpha = std::min(1.0f, dt * 12.0f);
+  const std::int64_t rttUs = wsClient_.smoothedRttUs();
+  if (rttUs >= 0) {
+    clockSync_.setRoundTripMs(rttUs / 1000);
+  }
+  const std::int64_t renderTimeMs =
+      clockSync_.toServer(static_cast<std::int64_t>(WorldState::nowMs())) - interpDelayMs_;
+  // Frame-rate independent smoothing for the predicted local player and for
+  // entities with no history yet.
+  const float alpha = 1.0f - std::exp(-dt * 12.0f);
+
   std::lock_guard<std::mutex> lock(world_.mutex);
-  for (auto& [_, p] : world_.data.players) {
-    p.renderX += (static_cast<float>(p.x) - p.renderX) * alpha;
-    p.renderY += (static_cast<float>(p.y) - p.renderY) * alpha;
+  const auto step = [&](SnapshotBuffer& history, const std::string& id, int x, int y, float& renderX,
+                        float& renderY) {
+    if (id != world_.data.localPlayerId && history.sample(id, renderTimeMs, renderX, renderY)) {
+      return;
+    }
+    renderX += (static_cast<float>(x) - renderX) * alpha;
+    renderY += (static_cast<float>(y) - renderY) * alpha;
+  };
+  for (auto& [id, p] : world_.data.players) {
+    step(playerHistory_, id, p.x, p.y, p.renderX, p.renderY);
   }
-  for (auto& [_, n] : world_.data.npcs) {
-    n.renderX += (static_cast<float>(n.x) - n.renderX) * alpha;
-    n.renderY += (static_cast<float>(n.y) - n.renderY) * alpha;
+  for (auto& [id, n] : world_.data.npcs) {
+    step(npcHistory_, id, n.x, n.y, n.renderX, n.renderY);
   }
-  for (auto& [_, m] : world_.data.mobs) {
-    m.renderX += (static_cast<float>(m.x) - m.renderX) * alpha;
-    m.renderY += (static_cast<float>(m.y) - m.renderY) * alpha;
+  for (auto& [id, m] : world_.data.mobs) {
+    step(mobHistory_, id, m.x, m.y, m.renderX, m.renderY);
   }
+  playerHistory_.retain(world_.data.players);
+  npcHistory_.retain(world_.data.npcs);
+  mobHistory_.retain(world_.data.mobs);
 }
 
 void GameClient::updateCombatEffects(float dt) {
@@ -917,7 +1313,7 @@ void GameClient::tryAttackNearest() {
   }
 
   json attackMsg{{"type", "attack"}, {"targetId", targetMobId}, {"mobId", targetMobId}};
-  wsClient_.sendText(attackMsg.dump());
+  sendWorldMessage(attackMsg, "attack:" + targetMobId);
 }
 
 void GameClient::tryInteractNearest() {
@@ -962,7 +1358,7 @@ void GameClient::tryInteractNearest() {
 
   lastInteractAtMs_ = now;
   json interactMsg{{"type", "interact"}, {"npcId", targetNpcId}, {"action", "talk"}};
-  wsClient_.sendText(interactMsg.dump());
+  sendWorldMessage(interactMsg, "interact:" + targetNpcId);
 }
 
 void GameClient::sendDialogSelection(const std::string& npcId, const std::string& responseId) {
@@ -970,383 +1366,422 @@ void GameClient::sendDialogSelection(const std::string& npcId, const std::string
     return;
   }
   json selectMsg{{"type", "dialog_select"}, {"npcId", npcId}, {"response_id", responseId}};
-  wsClient_.sendText(selectMsg.dump());
+  sendWorldMessage(selectMsg);
 }
 
-void GameClient::parseAndApplyMessage(const std::string& raw) {
-  try {
-    const json msg = json::parse(raw);
-    const std::string type = msg.value("type", "");
-
-    const auto text = getStringField(msg, {"message", "text", "error"});
-    if (type == "error") {
-      world_.pushError(text.value_or("Server error"));
-      return;
-    }
-
-    if (type == "welcome") {
-      {
-        std::lock_guard<std::mutex> lock(world_.mutex);
-        auto& data = world_.data;
-        data.worldReady = true;
-        data.lastServerUpdateMs = WorldState::nowMs();
+void GameClient::parseAndApplyMessage(const std::string& raw, bool binary, std::uint64_t receivedAtMs) {
+  const auto decodeStart = std::chrono::steady_clock::now();
+  decodeWorldMessage(raw, binary, scratchMessage_);
+  const std::uint64_t decodeNs = elapsedNs(decodeStart);
+  const auto applyStart = std::chrono::steady_clock::now();
+  recordEntitySamples(scratchMessage_.event, sampleTimeFor(scratchMessage_, receivedAtMs));
+  applyWorldMessage(scratchMessage_);
+  telemetry_.recordInbound(scratchMessage_.type, raw.size(), decodeNs, elapsedNs(applyStart));
+}
 
-        if (const auto selfId = getStringField(msg, {"selfId", "playerId", "id"}); selfId.has_value()) {
-          data.localPlayerId = selfId.value();
-        }
+std::int64_t GameClient::sampleTimeFor(const DecodedMessage& msg, std::uint64_t receivedAtMs) {
+  const auto localMs = static_cast<std::int64_t>(receivedAtMs);
+  if (msg.serverTimeMs > 0) {
+    clockSync_.addSample(msg.serverTimeMs, localMs);
+    return msg.serverTimeMs;
+  }
+  return clockSync_.toServer(localMs);
+}
 
-        if (msg.contains("world") && msg["world"].is_object()) {
-          const auto& w = msg["world"];
-          if (w.contains("map") && w["map"].is_object()) {
-            parseTiles(data, w["map"]);
-          } else if (w.contains("tiles")) {
-            parseTiles(data, w);
-          }
-          if (w.contains("players") && w["players"].is_array()) {
-            data.players.clear();
-            for (const auto& node : w["players"]) {
-              PlayerState p = parsePlayer(node);
-              if (!p.id.empty()) {
-                upsertEntity(data.players, p);
-              }
-            }
-          }
-          if (w.contains("npcs") && w["npcs"].is_array()) {
-            data.npcs.clear();
-            for (const auto& node : w["npcs"]) {
-              NpcState n = parseNpc(node);
-              if (!n.id.empty()) {
-                upsertEntity(data.npcs, n);
-              }
-            }
-          }
-          if (w.contains("mobs") && w["mobs"].is_array()) {
-            data.mobs.clear();
-            for (const auto& node : w["mobs"]) {
-              MobState m = parseMob(node);
-              if (!m.id.empty()) {
-                upsertEntity(data.mobs, m);
-              }
-            }
-          }
+// Runs before applyWorldMessage(), which may move entity lists out of `event`.
+void GameClient::recordEntitySamples(const WorldEvent& event, std::int64_t timeMs) {
+  if (const auto* ev = std::get_if<PlayerUpsert>(&event)) {
+    playerHistory_.record(ev->player.id, timeMs, static_cast<float>(ev->player.x), static_cast<float>(ev->player.y));
+  } else if (const auto* ev = std::get_if<MobUpsert>(&event)) {
+    for (const auto& mob : ev->mobs) {
+      mobHistory_.record(mob.id, timeMs, static_cast<float>(mob.x), static_cast<float>(mob.y));
+    }
+  } else if (const auto* ev = std::get_if<PlayerLeft>(&event)) {
+    playerHistory_.erase(ev->id);
+  } else if (const auto* ev = std::get_if<WorldDelta>(&event)) {
+    // Unchanged axes come from the current state.
+    const auto recordMoves = [timeMs](SnapshotBuffer& history, const auto& entities,
+                                      const std::vector<EntityDelta>& deltas) {
+      for (const auto& d : deltas) {
+        if ((d.mask & DeltaField::kPosition) == 0) {
+          continue;
         }
+        const auto it = entities.find(d.id);
+        const int x = (d.mask & DeltaField::kX) ? d.x : (it != entities.end() ? it->second.x : 0);
+        const int y = (d.mask & DeltaField::kY) ? d.y : (it != entities.end() ? it->second.y : 0);
+        history.record(d.id, timeMs, static_cast<float>(x), static_cast<float>(y));
+      }
+    };
+    std::lock_guard<std::mutex> lock(world_.mutex);
+    recordMoves(playerHistory_, world_.data.players, ev->players);
+    recordMoves(mobHistory_, world_.data.mobs, ev->mobs);
+  } else if (const auto* ev = std::get_if<Welcome>(&event)) {
+    const auto reseed = [timeMs](SnapshotBuffer& buffer, const auto& entities) {
+      buffer.clear();
+      for (const auto& e : entities) {
+        buffer.record(e.id, timeMs, static_cast<float>(e.x), static_cast<float>(e.y));
+      }
+    };
+    if (ev->players) {
+      reseed(playerHistory_, *ev->players);
+    }
+    if (ev->npcs) {
+      reseed(npcHistory_, *ev->npcs);
+    }
+    if (ev->mobs) {
+      reseed(mobHistory_, *ev->mobs);
+    }
+  }
+}
 
-        if (msg.contains("map") && msg["map"].is_object()) {
-          parseTiles(data, msg["map"]);
-        }
-        if (msg.contains("players") && msg["players"].is_array()) {
-          data.players.clear();
-          for (const auto& node : msg["players"]) {
-            PlayerState p = parsePlayer(node);
-            if (!p.id.empty()) {
-              upsertEntity(data.players, p);
-            }
-          }
-        }
-        if (msg.contains("npcs") && msg["npcs"].is_array()) {
-          data.npcs.clear();
-          for (const auto& node : msg["npcs"]) {
-            NpcState n = parseNpc(node);
-            if (!n.id.empty()) {
-              upsertEntity(data.npcs, n);
-            }
-          }
-        }
-        if (msg.contains("mobs") && msg["mobs"].is_array()) {
-          data.mobs.clear();
-          for (const auto& node : msg["mobs"]) {
-            MobState m = parseMob(node);
-            if (!m.id.empty()) {
-              upsertEntity(data.mobs, m);
-            }
-          }
+void GameClient::applyWorldDelta(const WorldDelta& delta, std::uint64_t previousSeq) {
+  bool baselineMissing = false;
+  {
+    std::lock_guard<std::mutex> lock(world_.mutex);
+    auto& data = world_.data;
+    // A delta is only valid on top of the state it was computed from.
+    if (!data.worldReady || delta.baselineSeq > previousSeq) {
+      baselineMissing = true;
+    } else {
+      for (const auto& d : delta.players) {
+        PlayerState* player = deltaTarget(data.players, d);
+        if (player == nullptr) {
+          baselineMissing = baselineMissing || !interest_.wasEvicted(d.id);
+          continue;
         }
-
-        if (data.players.find(data.localPlayerId) == data.players.end()) {
-          PlayerState self;
-          self.id = data.localPlayerId.empty() ? (characters_.empty() ? username_ : characters_[selectedCharacterIndex_].id) : data.localPlayerId;
-          self.name = characters_.empty() ? username_ : characters_[selectedCharacterIndex_].name;
-          self.className = characters_.empty() ? "unknown" : characters_[selectedCharacterIndex_].className;
-          upsertEntity(data.players, self);
+        applyDeltaFields(*player, d);
+        if (d.id == data.localPlayerId && (d.mask & DeltaField::kPosition) != 0) {
+          authoritativeSelfX_ = (d.mask & DeltaField::kX) ? d.x : authoritativeSelfX_;
+          authoritativeSelfY_ = (d.mask & DeltaField::kY) ? d.y : authoritativeSelfY_;
+          player->x = authoritativeSelfX_;
+          player->y = authoritativeSelfY_;
+          reconcileLocalPlayer(data, *player, delta.ackInputSeq);
         }
-
-        // Override self position from server-provided character data in welcome message
-        if (msg.contains("character") && msg["character"].is_object()) {
-          const auto& charObj = msg["character"];
-          if (auto selfIt = data.players.find(data.localPlayerId); selfIt != data.players.end()) {
-            if (auto posX = getIntField(charObj, {"pos_x", "x"}); posX.has_value()) {
-              selfIt->second.x = *posX;
-              selfIt->second.renderX = static_cast<float>(*posX);
-            }
-            if (auto posY = getIntField(charObj, {"pos_y", "y"}); posY.has_value()) {
-              selfIt->second.y = *posY;
-              selfIt->second.renderY = static_cast<float>(*posY);
-            }
-          }
+      }
+      for (const auto& d : delta.mobs) {
+        MobState* mob = deltaTarget(data.mobs, d);
+        if (mob == nullptr) {
+          baselineMissing = baselineMissing || !interest_.wasEvicted(d.id);
+          continue;
         }
+        applyDeltaFields(*mob, d);
       }
-      world_.pushChat("Joined world");
-      return;
-    }
-
-    if (type == "player_joined" || type == "player_moved" || type == "player_update") {
-      const json& playerNode = (msg.contains("player") && msg["player"].is_object()) ? msg["player"] : msg;
-      PlayerState p = parsePlayer(playerNode);
-      if (p.id.empty()) {
-        return;
+      for (const auto& id : delta.removedPlayers) {
+        data.players.erase(id);
       }
-      std::lock_guard<std::mutex> lock(world_.mutex);
-      upsertEntity(world_.data.players, p);
-      if (type == "player_joined") {
-        world_.data.chatLines.push_back(ChatLine{p.name + " joined the world", WorldState::nowMs()});
-        while (world_.data.chatLines.size() > 12) {
-          world_.data.chatLines.pop_front();
-        }
+      for (const auto& id : delta.removedMobs) {
+        data.mobs.erase(id);
       }
-      return;
+      data.lastServerUpdateMs = WorldState::nowMs();
     }
+  }
+  if (baselineMissing) {
+    requestResync();
+  }
+}
 
-    if (type == "player_left") {
-      const std::string id = getStringField(msg, {"playerId", "id"}).value_or("");
-      if (id.empty()) {
-        return;
-      }
+void GameClient::requestResync() {
+  const std::uint64_t now = WorldState::nowMs();
+  if (resyncRequestedAtMs_ != 0 && now - resyncRequestedAtMs_ < kResyncRetryMs) {
+    return;
+  }
+  resyncRequestedAtMs_ = now;
+  json resyncMsg{{"type", "resync_request"}, {"last_seq", lastServerSeq_}};
+  sendWorldMessage(resyncMsg);
+  std::printf("[client] world_delta baseline missing, requested resync at seq %llu\n",
+              static_cast<unsigned long long>(lastServerSeq_));
+}
+
+void GameClient::applyWorldMessage(DecodedMessage& msg) {
+  const std::uint64_t previousSeq = lastServerSeq_;
+  // A resume can replay seqs that were already applied from the old socket.
+  const bool sessionControl =
+      std::holds_alternative<Welcome>(msg.event) || std::holds_alternative<Resumed>(msg.event);
+  if (!sessionControl && msg.seq != 0 && msg.seq <= previousSeq) {
+    return;
+  }
+  if (std::holds_alternative<Welcome>(msg.event)) {
+    lastServerSeq_ = msg.seq;
+  } else if (msg.seq > lastServerSeq_) {
+    lastServerSeq_ = msg.seq;
+  }
+
+  if (const auto* ev = std::get_if<WorldDelta>(&msg.event)) {
+    applyWorldDelta(*ev, previousSeq);
+    return;
+  }
+
+  if (const auto* ev = std::get_if<WorldError>(&msg.event)) {
+    world_.pushError(ev->text);
+    return;
+  }
+
+  if (auto* ev = std::get_if<Welcome>(&msg.event)) {
+    {
       std::lock_guard<std::mutex> lock(world_.mutex);
-      world_.data.players.erase(id);
-      world_.data.chatLines.push_back(ChatLine{id + " left the world", WorldState::nowMs()});
-      while (world_.data.chatLines.size() > 12) {
-        world_.data.chatLines.pop_front();
+      auto& data = world_.data;
+      data.worldReady = true;
+      data.lastServerUpdateMs = WorldState::nowMs();
+
+      if (ev->selfId.has_value()) {
+        data.localPlayerId = *ev->selfId;
+      }
+      outboundEncoding_ = ev->encoding.value_or(WireEncoding::Json);
+      negotiatedEncoding_ = outboundEncoding_;
+      wsClient_.resetReconnectBackoff();
+      movePredictor_.clear();  // a fresh snapshot supersedes any unacked input
+      interest_.clearEvicted();
+      resyncRequestedAtMs_ = 0;
+      if (ev->map.has_value()) {
+        applyTileMap(data, *ev->map);
+      }
+      if (ev->players.has_value()) {
+        replaceEntities(data.players, *ev->players);
+      }
+      if (ev->npcs.has_value()) {
+        replaceEntities(data.npcs, *ev->npcs);
+      }
+      if (ev->mobs.has_value()) {
+        replaceEntities(data.mobs, *ev->mobs);
       }
-      return;
-    }
 
-    if (type == "mob_update") {
-      std::lock_guard<std::mutex> lock(world_.mutex);
-      if (msg.contains("mobs") && msg["mobs"].is_array()) {
-        for (const auto& node : msg["mobs"]) {
-          MobState mob = parseMob(node);
-          if (!mob.id.empty()) {
-            upsertEntity(world_.data.mobs, mob);
-          }
+      if (data.players.find(data.localPlayerId) == data.players.end()) {
+        PlayerState self;
+        self.id = data.localPlayerId.empty() ? (characters_.empty() ? username_ : characters_[selectedCharacterIndex_].id) : data.localPlayerId;
+        self.name = characters_.empty() ? username_ : characters_[selectedCharacterIndex_].name;
+        self.className = characters_.empty() ? "unknown" : characters_[selectedCharacterIndex_].className;
+        upsertEntity(data.players, self);
+      }
+
+      // Override self position from server-provided character data in welcome message
+      if (auto selfIt = data.players.find(data.localPlayerId); selfIt != data.players.end()) {
+        if (ev->selfX.has_value()) {
+          selfIt->second.x = *ev->selfX;
+          selfIt->second.renderX = static_cast<float>(*ev->selfX);
         }
-      } else {
-        const json& mobNode = (msg.contains("mob") && msg["mob"].is_object()) ? msg["mob"] : msg;
-        MobState mob = parseMob(mobNode);
-        if (!mob.id.empty()) {
-          upsertEntity(world_.data.mobs, mob);
+        if (ev->selfY.has_value()) {
+          selfIt->second.y = *ev->selfY;
+          selfIt->second.renderY = static_cast<float>(*ev->selfY);
         }
+        authoritativeSelfX_ = selfIt->second.x;
+        authoritativeSelfY_ = selfIt->second.y;
       }
-      return;
     }
+    world_.pushChat("Joined world");
+    return;
+  }
 
-    if (type == "combat") {
-      std::string targetId = getStringField(msg, {"targetId", "mobId", "victimId"}).value_or("");
-      const int damage = getIntField(msg, {"damage", "amount"}).value_or(0);
+  if (const auto* ev = std::get_if<Resumed>(&msg.event)) {
+    // Entity maps are kept; the server replays the missed deltas next.
+    outboundEncoding_ = ev->encoding.value_or(negotiatedEncoding_);
+    negotiatedEncoding_ = outboundEncoding_;
+    wsClient_.resetReconnectBackoff();
+    {
       std::lock_guard<std::mutex> lock(world_.mutex);
-      float fxX = 0.0f;
-      float fxY = 0.0f;
-      if (auto it = world_.data.mobs.find(targetId); it != world_.data.mobs.end()) {
-        it->second.hp = std::max(0, it->second.hp - damage);
-        it->second.alive = it->second.hp > 0;
-        fxX = static_cast<float>(it->second.x);
-        fxY = static_cast<float>(it->second.y);
-      } else if (auto pit = world_.data.players.find(targetId); pit != world_.data.players.end()) {
-        pit->second.hp = std::max(0, pit->second.hp - damage);
-        pit->second.alive = pit->second.hp > 0;
-        fxX = static_cast<float>(pit->second.x);
-        fxY = static_cast<float>(pit->second.y);
-      }
-      FloatingCombatText fx;
-      fx.text = "-" + std::to_string(damage);
-      fx.worldX = fxX;
-      fx.worldY = fxY;
-      fx.r = 255;
-      fx.g = 80;
-      fx.b = 80;
-      world_.data.combatTexts.push_back(fx);
-      while (world_.data.combatTexts.size() > 32) {
-        world_.data.combatTexts.pop_front();
-      }
-      if (damage > 0) {
-        world_.data.chatLines.push_back(ChatLine{"Combat: " + std::to_string(damage) + " damage", WorldState::nowMs()});
-        while (world_.data.chatLines.size() > 12) {
-          world_.data.chatLines.pop_front();
-        }
-      }
-      return;
+      world_.data.worldReady = true;
+      world_.data.lastServerUpdateMs = WorldState::nowMs();
     }
+    world_.pushChat("Session resumed");
+    return;
+  }
 
-    if (type == "player_died") {
-      const std::string id = getStringField(msg, {"playerId", "id"}).value_or("");
-      if (id.empty()) {
-        return;
-      }
-      std::lock_guard<std::mutex> lock(world_.mutex);
-      auto it = world_.data.players.find(id);
-      if (it != world_.data.players.end()) {
-        it->second.hp = 0;
-        it->second.alive = false;
-      }
-      world_.data.chatLines.push_back(ChatLine{id + " died", WorldState::nowMs()});
-      while (world_.data.chatLines.size() > 12) {
-        world_.data.chatLines.pop_front();
+  if (const auto* ev = std::get_if<InterestAck>(&msg.event)) {
+    interest_.acknowledge(ev->hasArea ? TileRect{ev->x, ev->y, ev->x + ev->w - 1, ev->y + ev->h - 1}
+                                      : interest_.area());
+    return;
+  }
+
+  if (const auto* ev = std::get_if<InterestLeave>(&msg.event)) {
+    std::lock_guard<std::mutex> lock(world_.mutex);
+    auto& data = world_.data;
+    for (const auto& id : ev->players) {
+      if (id != data.localPlayerId) {
+        interest_.noteEvicted(id);
+        playerHistory_.erase(id);
+        data.players.erase(id);
       }
-      return;
     }
+    for (const auto& id : ev->mobs) {
+      interest_.noteEvicted(id);
+      mobHistory_.erase(id);
+      data.mobs.erase(id);
+    }
+    return;
+  }
 
-    if (type == "dialog_start" || type == "dialog_update") {
-      const json& node = (msg.contains("node") && msg["node"].is_object()) ? msg["node"] : msg;
-      DialogState dialog;
-      dialog.active = true;
-      dialog.npcId = getStringField(msg, {"npc_id", "npcId"}).value_or("");
-      dialog.npcName = getStringField(msg, {"npc_name", "npcName"}).value_or(dialog.npcId);
-      dialog.npcRole = getStringField(msg, {"npc_role", "npcRole"}).value_or("");
-      dialog.npcPortrait = getStringField(msg, {"npc_portrait", "npcPortrait"}).value_or("");
-      dialog.nodeId = getStringField(node, {"id", "node_id"}).value_or("");
-      dialog.text = getStringField(node, {"text", "message"}).value_or("");
-      dialog.responses = parseDialogResponses(node);
-
-      {
-        std::lock_guard<std::mutex> lock(world_.mutex);
-        // Fill missing metadata from world snapshot for stable UI.
-        if (auto npcIt = world_.data.npcs.find(dialog.npcId); npcIt != world_.data.npcs.end()) {
-          if (dialog.npcName.empty()) {
-            dialog.npcName = npcIt->second.name;
-          }
-          if (dialog.npcRole.empty()) {
-            dialog.npcRole = npcIt->second.role;
-          }
-          if (dialog.npcPortrait.empty()) {
-            dialog.npcPortrait = npcIt->second.portrait;
-          }
-        }
-        world_.data.dialog = dialog;
-      }
-      if (const auto questTrigger = getStringField(msg, {"quest_trigger", "questTrigger"}); questTrigger && !questTrigger->empty()) {
-        world_.pushChat("Quest triggered: " + *questTrigger);
-      }
-      return;
+  if (const auto* ev = std::get_if<PlayerUpsert>(&msg.event)) {
+    std::lock_guard<std::mutex> lock(world_.mutex);
+    upsertEntity(world_.data.players, ev->player);
+    if (ev->player.id == world_.data.localPlayerId) {
+      reconcileLocalPlayer(world_.data, world_.data.players[ev->player.id], ev->ackInputSeq);
+    }
+    if (ev->joined) {
+      pushChatLine(world_.data, ev->player.name + " joined the world");
     }
+    return;
+  }
 
-    if (type == "dialog_end") {
-      std::string questTrigger = getStringField(msg, {"quest_trigger", "questTrigger"}).value_or("");
-      std::string npcName = getStringField(msg, {"npc_name", "npcName"}).value_or("");
-      if (npcName.empty()) {
-        const std::string npcId = getStringField(msg, {"npc_id", "npcId"}).value_or("");
-        std::lock_guard<std::mutex> lock(world_.mutex);
-        if (auto it = world_.data.npcs.find(npcId); it != world_.data.npcs.end()) {
-          npcName = it->second.name;
-        }
-      }
-      {
-        std::lock_guard<std::mutex> lock(world_.mutex);
-        world_.data.dialog = DialogState{};
-      }
-      if (!npcName.empty()) {
-        world_.pushChat("Conversation ended with " + npcName);
-      }
-      if (!questTrigger.empty()) {
-        world_.pushChat("Quest triggered: " + questTrigger);
-      }
-      return;
+  if (const auto* ev = std::get_if<PlayerLeft>(&msg.event)) {
+    std::lock_guard<std::mutex> lock(world_.mutex);
+    world_.data.players.erase(ev->id);
+    pushChatLine(world_.data, ev->id + " left the world");
+    return;
+  }
+
+  if (const auto* ev = std::get_if<MobUpsert>(&msg.event)) {
+    std::lock_guard<std::mutex> lock(world_.mutex);
+    for (const auto& mob : ev->mobs) {
+      upsertEntity(world_.data.mobs, mob);
     }
+    return;
+  }
 
-    if (type == "npc_response") {
-      std::string npcId = getStringField(msg, {"npcId", "id"}).value_or("");
-      std::string npcText;
-      std::vector<std::string> optionLabels;
+  if (const auto* ev = std::get_if<Combat>(&msg.event)) {
+    const int damage = ev->damage;
+    std::lock_guard<std::mutex> lock(world_.mutex);
+    float fxX = 0.0f;
+    float fxY = 0.0f;
+    if (auto it = world_.data.mobs.find(ev->targetId); it != world_.data.mobs.end()) {
+      it->second.hp = std::max(0, it->second.hp - damage);
+      it->second.alive = it->second.hp > 0;
+      fxX = static_cast<float>(it->second.x);
+      fxY = static_cast<float>(it->second.y);
+    } else if (auto pit = world_.data.players.find(ev->targetId); pit != world_.data.players.end()) {
+      pit->second.hp = std::max(0, pit->second.hp - damage);
+      pit->second.alive = pit->second.hp > 0;
+      fxX = static_cast<float>(pit->second.x);
+      fxY = static_cast<float>(pit->second.y);
+    }
+    FloatingCombatText fx;
+    fx.text = "-" + std::to_string(damage);
+    fx.worldX = fxX;
+    fx.worldY = fxY;
+    fx.r = 255;
+    fx.g = 80;
+    fx.b = 80;
+    world_.data.combatTexts.push_back(fx);
+    while (world_.data.combatTexts.size() > 32) {
+      world_.data.combatTexts.pop_front();
+    }
+    if (damage > 0) {
+      pushChatLine(world_.data, "Combat: " + std::to_string(damage) + " damage");
+    }
+    return;
+  }
 
-      if (msg.contains("result") && msg["result"].is_object()) {
-        const auto& result = msg["result"];
-        if (result.contains("text") && result["text"].is_string()) {
-          npcText = result["text"].get<std::string>();
+  if (const auto* ev = std::get_if<PlayerDied>(&msg.event)) {
+    std::lock_guard<std::mutex> lock(world_.mutex);
+    auto it = world_.data.players.find(ev->id);
+    if (it != world_.data.players.end()) {
+      it->second.hp = 0;
+      it->second.alive = false;
+    }
+    pushChatLine(world_.data, ev->id + " died");
+    return;
+  }
+
+  if (auto* ev = std::get_if<DialogStart>(&msg.event)) {
+    DialogState& dialog = ev->dialog;
+    {
+      std::lock_guard<std::mutex> lock(world_.mutex);
+      // Fill missing metadata from world snapshot for stable UI.
+      if (auto npcIt = world_.data.npcs.find(dialog.npcId); npcIt != world_.data.npcs.end()) {
+        if (dialog.npcName.empty()) {
+          dialog.npcName = npcIt->second.name;
         }
-        if (result.contains("options") && result["options"].is_array()) {
-          for (const auto& option : result["options"]) {
-            if (option.is_string()) {
-              optionLabels.push_back(option.get<std::string>());
-              continue;
-            }
-            if (option.is_object()) {
-              const auto label = getStringField(option, {"label", "text", "name", "id"});
-              if (label.has_value() && !label->empty()) {
-                optionLabels.push_back(label.value());
-              }
-            }
-          }
+        if (dialog.npcRole.empty()) {
+          dialog.npcRole = npcIt->second.role;
         }
-      }
-
-      if (npcText.empty()) {
-        npcText = getStringField(msg, {"text", "message"}).value_or("");
-      }
-      if (optionLabels.empty() && msg.contains("options") && msg["options"].is_array()) {
-        for (const auto& option : msg["options"]) {
-          if (option.is_string()) {
-            optionLabels.push_back(option.get<std::string>());
-          } else if (option.is_object()) {
-            const auto label = getStringField(option, {"label", "text", "name", "id"});
-            if (label.has_value() && !label->empty()) {
-              optionLabels.push_back(label.value());
-            }
-          }
+        if (dialog.npcPortrait.empty()) {
+          dialog.npcPortrait = npcIt->second.portrait;
         }
       }
+      world_.data.dialog = std::move(dialog);
+    }
+    if (!ev->questTrigger.empty()) {
+      world_.pushChat("Quest triggered: " + ev->questTrigger);
+    }
+    return;
+  }
 
-      std::string npcName = npcId;
-      {
-        std::lock_guard<std::mutex> lock(world_.mutex);
-        auto npcIt = world_.data.npcs.find(npcId);
-        if (npcIt != world_.data.npcs.end() && !npcIt->second.name.empty()) {
-          npcName = npcIt->second.name;
+  if (const auto* ev = std::get_if<DialogEnd>(&msg.event)) {
+    std::string npcName = ev->npcName;
+    {
+      std::lock_guard<std::mutex> lock(world_.mutex);
+      if (npcName.empty()) {
+        if (auto it = world_.data.npcs.find(ev->npcId); it != world_.data.npcs.end()) {
+          npcName = it->second.name;
         }
       }
+      world_.data.dialog = DialogState{};
+    }
+    if (!npcName.empty()) {
+      world_.pushChat("Conversation ended with " + npcName);
+    }
+    if (!ev->questTrigger.empty()) {
+      world_.pushChat("Quest triggered: " + ev->questTrigger);
+    }
+    return;
+  }
 
-      if (!npcText.empty()) {
-        const std::string prefix = npcName.empty() ? "[NPC] " : ("[" + npcName + "] ");
-        world_.pushChat(prefix + npcText);
+  if (const auto* ev = std::get_if<NpcResponse>(&msg.event)) {
+    std::string npcName = ev->npcId;
+    {
+      std::lock_guard<std::mutex> lock(world_.mutex);
+      auto npcIt = world_.data.npcs.find(ev->npcId);
+      if (npcIt != world_.data.npcs.end() && !npcIt->second.name.empty()) {
+        npcName = npcIt->second.name;
       }
-      if (!optionLabels.empty()) {
-        std::string optionsStr;
-        for (std::size_t i = 0; i < optionLabels.size(); ++i) {
-          if (i > 0) {
-            optionsStr += ", ";
-          }
-          optionsStr += optionLabels[i];
+    }
+
+    if (!ev->text.empty()) {
+      const std::string prefix = npcName.empty() ? "[NPC] " : ("[" + npcName + "] ");
+      world_.pushChat(prefix + ev->text);
+    }
+    if (!ev->options.empty()) {
+      std::string optionsStr;
+      for (std::size_t i = 0; i < ev->options.size(); ++i) {
+        if (i > 0) {
+          optionsStr += ", ";
         }
-        world_.pushChat("NPC Options: " + optionsStr);
+        optionsStr += ev->options[i];
       }
-      return;
+      world_.pushChat("NPC Options: " + optionsStr);
     }
+    return;
+  }
 
-    if (text.has_value() && !text->empty()) {
-      world_.pushChat(text.value());
-    }
-  } catch (const std::exception& ex) {
-    world_.pushError(std::string("Invalid JSON: ") + ex.what());
+  if (const auto* ev = std::get_if<ChatNotice>(&msg.event)) {
+    world_.pushChat(ev->text);
   }
 }
 
 void GameClient::processNetworkMessages() {
-  for (const std::string& raw : wsClient_.pollMessages()) {
-    parseAndApplyMessage(raw);
+  const WebSocketClient::InboundView view = wsClient_.acquireMessages();
+  for (InboundMessage& msg : view) {
+    if (wsClient_.isCurrent(msg) && !msg.isDecoded) {
+      const auto start = std::chrono::steady_clock::now();
+      decodeWorldMessage(msg.payload(), msg.binary, msg.decoded);
+      msg.decodeNs = elapsedNs(start);
+      msg.isDecoded = true;
+    }
   }
-}
 
-void GameClient::maybeReconnect(float dt) {
-  if (!reconnectEnabled_ || screen_ != ScreenState::World || wsClient_.isConnected()) {
-    reconnectAccumulator_ = 0.0f;
-    return;
+  // After a hitch only the newest position/HP per entity matters.
+  const std::size_t folded = coalescer_.fold(view, wsClient_);
+  if (folded > 0) {
+    telemetry_.recordFolded(folded);
   }
-  reconnectAccumulator_ += dt;
-  if (reconnectAccumulator_ < 3.0f) {
-    return;
-  }
-  reconnectAccumulator_ = 0.0f;
-  if (wsClient_.connect(wsUrl_, jwt_)) {
-    joinSent_ = false;
-    world_.pushChat("Reconnected to world socket");
+
+  for (InboundMessage& msg : view) {
+    if (wsClient_.isCurrent(msg)) {
+      const auto start = std::chrono::steady_clock::now();
+      recordEntitySamples(msg.decoded.event, sampleTimeFor(msg.decoded, msg.receivedAtMs));
+      applyWorldMessage(msg.decoded);
+      telemetry_.recordInbound(msg.decoded.type, msg.payload().size(), msg.decodeNs, elapsedNs(start));
+    }
   }
+  wsClient_.releaseMessages(view);
 }
 
 void GameClient::render() {
@@ -1635,6 +2070,9 @@ void GameClient::renderWorldScreen() {
     drawLabel(*it, 360, 20 + static_cast<float>(line) * 20.0f, 16, sf::Color(255, 125, 110));
   }
 
+  if (telemetryOverlay_) {
+    renderTelemetryOverlay();
+  }
   if (settingsMenuOpen_) {
     renderSettingsMenu();
     return;
@@ -1644,6 +2082,59 @@ void GameClient::renderWorldScreen() {
   }
 }
 
+void GameClient::renderTelemetryOverlay() {
+  constexpr std::size_t kRows = 10;
+  const auto rows = telemetry_.topByCost(kRows);
+  const float width = 520.0f;
+  const float height = 108.0f + static_cast<float>(httpTimings_.size() + rows.size()) * 17.0f;
+  const float x = static_cast<float>(window_.getSize().x) - width - 14.0f;
+  const float y = 10.0f;
+
+  sf::RectangleShape panel(sf::Vector2f(width, height));
+  panel.setPosition(x, y);
+  panel.setFillColor(sf::Color(10, 12, 18, 210));
+  panel.setOutlineThickness(1.0f);
+  panel.setOutlineColor(sf::Color(200, 205, 220, 120));
+  window_.draw(panel);
+
+  const sf::Color header(150, 200, 255);
+  const sf::Color body(220, 225, 235);
+  const std::int64_t rtt = wsClient_.smoothedRttUs();
+  const WebSocketClient::ByteStats bytes = wsClient_.byteStats();
+  drawLabel("Network (F3)  RTT: " + (rtt < 0 ? std::string("--") : std::to_string(rtt / 1000) + " ms"), x + 10,
+            y + 8, 15, header);
+  drawLabel("Queue: " + std::to_string(wsClient_.inboundDepth()) + "  peak " +
+                std::to_string(wsClient_.inboundHighWater()) + "  spilled " +
+                std::to_string(wsClient_.spilledInbound()) + "  folded " +
+                std::to_string(telemetry_.foldedUpdates()) + " in " + std::to_string(telemetry_.foldedBatches()),
+            x + 10, y + 30, 14, body);
+  drawLabel("Wire in/out: " + formatKb(bytes.wireIn) + " / " + formatKb(bytes.wireOut) + "  payload " +
+                formatKb(bytes.payloadIn) + " / " + formatKb(bytes.payloadOut) + "  coalesced " +
+                std::to_string(wsClient_.coalescedOutbound()) + "  timeouts " +
+                std::to_string(wsClient_.heartbeatTimeouts()),
+            x + 10, y + 50, 14, body);
+  float rowY = y + 70;
+  for (const HttpTiming& t : httpTimings_) {
+    drawLabel(formatHttpTiming(t), x + 10, rowY, 13, body);
+    rowY += 17.0f;
+  }
+  drawLabel("type", x + 10, rowY + 8, 14, header);
+  drawLabel("in/out", x + 170, rowY + 8, 14, header);
+  drawLabel("bytes", x + 260, rowY + 8, 14, header);
+  drawLabel("dec/apply us", x + 350, rowY + 8, 14, header);
+
+  rowY += 28.0f;
+  for (const auto& [type, stats] : rows) {
+    const std::uint64_t n = std::max<std::uint64_t>(stats.received, 1);
+    drawLabel(type, x + 10, rowY, 13, body);
+    drawLabel(std::to_string(stats.received) + "/" + std::to_string(stats.sent), x + 170, rowY, 13, body);
+    drawLabel(formatKb(stats.bytesIn + stats.bytesOut), x + 260, rowY, 13, body);
+    drawLabel(std::to_string(stats.decodeNs / n / 1000) + "/" + std::to_string(stats.applyNs / n / 1000), x + 350,
+              rowY, 13, body);
+    rowY += 17.0f;
+  }
+}
+
 void GameClient::renderDialogOverlay(const WorldSnapshot& snapshot) {
   dialogOptionRects_.clear();
   const DialogState& dialog = snapshot.dialog;
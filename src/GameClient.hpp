@@ -2,20 +2,35 @@
 
 #include <SFML/Graphics.hpp>
 
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "ClientOptions.hpp"
 #include "HttpAuthClient.hpp"
+#include "InterestArea.hpp"
+#include "Interpolation.hpp"
+#include "MovePredictor.hpp"
+#include "NetworkTelemetry.hpp"
 #include "Renderer3D.hpp"
+#include "SessionRecording.hpp"
+#include "UpdateCoalescer.hpp"
 #include "WebSocketClient.hpp"
+#include "WorldEvents.hpp"
 #include "WorldState.hpp"
+#include "nlohmann/json_fwd.hpp"
 
 class GameClient {
  public:
-  GameClient(std::string httpUrl, std::string wsUrl);
+  GameClient(std::string httpUrl, std::string wsUrl, const ClientOptions& options = {});
   void run();
 
+  const NetworkTelemetry& telemetry() const { return telemetry_; }
+  const WebSocketClient& worldSocket() const { return wsClient_; }
+
  private:
   enum class ScreenState { Auth, CharacterSelect, CharacterCreate, World };
   enum class AuthMode { Login, Register };
@@ -47,27 +62,56 @@ class GameClient {
   void saveSettings() const;
 
   void submitAuth();
+  bool httpBusy() const;
+  void beginHttpProgress(const std::string& label);
+  void cancelHttpRequests();
+  void pollHttpRequests();
+  void resumeStoredSession();
+  void requestCharacters(const std::string& progressLabel);
+  void showCharacters(std::vector<CharacterInfo> characters);
+  void preconnectWorld();
+  void dropPreconnect();
   void startWorldSession();
   void leaveWorldSession();
+  void resetSessionState();
+  void startReplaySession();
+  void feedReplay(float dt);
+  void finishReplay();
 
   void updateMovement(float dt);
+  void updateInterest();
   void updateInterpolations(float dt);
   void updateCombatEffects(float dt);
   void tryAttackNearest();
   void tryInteractNearest();
   void sendDialogSelection(const std::string& npcId, const std::string& responseId);
   void sendMoveCommand(int dx, int dy);
-  void parseAndApplyMessage(const std::string& raw);
+  void reconcileLocalPlayer(WorldSnapshot& data, PlayerState& self, std::uint32_t ackInputSeq);
+  bool sendWorldMessage(const nlohmann::json& msg, const std::string& coalesceKey = {});
+  void parseAndApplyMessage(const std::string& raw, bool binary, std::uint64_t receivedAtMs);
+  void applyWorldMessage(DecodedMessage& msg);
+  void applyWorldDelta(const WorldDelta& delta, std::uint64_t previousSeq);
+  void requestResync();
+  std::int64_t sampleTimeFor(const DecodedMessage& msg, std::uint64_t receivedAtMs);
+  void recordEntitySamples(const WorldEvent& event, std::int64_t timeMs);
   void processNetworkMessages();
   void sendJoinIfNeeded();
-  void maybeReconnect(float dt);
 
+  void renderTelemetryOverlay();
   void drawLabel(const std::string& text, float x, float y, unsigned size = 22,
                  const sf::Color& color = sf::Color::White);
 
   sf::RenderWindow window_;
   Renderer3D renderer_;
   HttpAuthClient authClient_;
+  PendingRequest<AuthResult> authRequest_;
+  PendingRequest<CharacterList> charactersRequest_;
+  PendingRequest<std::optional<CharacterInfo>> createRequest_;
+  std::string httpLabel_;  // progress text while one of the requests above is in flight
+  std::uint64_t httpStartedAtMs_ = 0;
+  std::deque<HttpTiming> httpTimings_;  // most recent last; shown in the F3 overlay
+  bool resumingSession_ = false;          // charactersRequest_ is validating a stored token
+  bool showingCachedCharacters_ = false;  // charactersRequest_ is revalidating the list on screen
   WebSocketClient wsClient_;
   std::string wsUrl_;
 
@@ -88,13 +132,44 @@ class GameClient {
   std::size_t localCharacterCounter_ = 1;
 
   WorldState world_;
-  bool joinSent_ = false;
+  DecodedMessage scratchMessage_;
+  UpdateCoalescer coalescer_;
+  NetworkTelemetry telemetry_;
+  bool telemetryOverlay_ = false;
+  ClockSync clockSync_;
+  SnapshotBuffer playerHistory_;
+  SnapshotBuffer npcHistory_;
+  SnapshotBuffer mobHistory_;
+  int interpDelayMs_ = 100;  // remote entities render this far behind server time
+  MovePredictor movePredictor_;
+  InterestArea interest_;
+  std::unique_ptr<SessionReplayer> replayer_;
+  std::string replayPath_;
+  double replaySpeed_ = 1.0;
+  double replayClockUs_ = 0.0;
+  SessionRecord replayRecord_;
+  bool replayRecordPending_ = false;
+  std::uint64_t replayInbound_ = 0;
+  std::uint64_t replayOutbound_ = 0;
+  std::chrono::steady_clock::time_point replayStartedAt_;
+  std::uint64_t replayBaseMs_ = 0;  // WorldState::nowMs() at replay start; record times are added to it
+  int authoritativeSelfX_ = 0;  // last server-confirmed local position
+  int authoritativeSelfY_ = 0;
+  std::uint64_t resyncRequestedAtMs_ = 0;
+  bool decodeOnNetworkThread_ = true;
+  bool wsCompression_ = true;
+  bool binaryEncoding_ = true;
+  WireEncoding outboundEncoding_ = WireEncoding::Json;
+  WireEncoding negotiatedEncoding_ = WireEncoding::Json;  // from the last welcome/resumed
+  std::uint32_t joinedConnectionId_ = 0;  // wsClient_.connectionId() our join went to
+  std::uint64_t preconnectStartedAtMs_ = 0;  // non-zero while a socket waits for a character choice
   float moveAccumulator_ = 0.0f;
   std::uint64_t lastMoveAtMs_ = 0;
   std::uint64_t lastAttackAtMs_ = 0;
   std::uint64_t lastInteractAtMs_ = 0;
-  float reconnectAccumulator_ = 0.0f;
   bool reconnectEnabled_ = true;
+  HeartbeatOptions heartbeat_;
+  std::uint64_t lastServerSeq_ = 0;
   bool settingsMenuOpen_ = false;
   bool draggingZoomSlider_ = false;
   float settingsZoom_ = 0.75f;
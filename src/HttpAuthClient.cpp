@@ -1,5 +1,7 @@
 #include "HttpAuthClient.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <sstream>
 
 #include "httplib.h"
@@ -7,6 +9,20 @@
 
 using json = nlohmann::json;
 
+// httplib's client with the connect step exposed, so a new connection's TCP
+// handshake can be timed apart from the request.
+class HttpConnection : public httplib::ClientImpl {
+ public:
+  using httplib::ClientImpl::ClientImpl;
+
+  // Connects unless the keep-alive socket is already open; send() then finds
+  // it alive and writes the request straight away.
+  bool open(httplib::Error& error) {
+    std::lock_guard<std::mutex> guard(socket_mutex_);
+    return socket_.is_open() || create_and_connect_socket(socket_, error);
+  }
+};
+
 namespace {
 std::pair<std::string, int> parseHostPort(const std::string& baseUrl) {
   std::string stripped = baseUrl;
@@ -34,6 +50,23 @@ std::pair<std::string, int> parseHostPort(const std::string& baseUrl) {
   return {stripped.substr(0, colon), port};
 }
 
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point from, Clock::time_point to) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+httplib::Request makeRequest(const char* method, const std::string& path, std::string body) {
+  httplib::Request req;
+  req.method = method;
+  req.path = path;
+  if (!body.empty()) {
+    req.set_header("Content-Type", "application/json");
+    req.body = std::move(body);
+  }
+  return req;
+}
+
 std::string extractToken(const json& body) {
   if (body.contains("token") && body["token"].is_string()) {
     return body["token"].get<std::string>();
@@ -48,42 +81,227 @@ std::string extractToken(const json& body) {
 }
 }  // namespace
 
+void RequestControl::cancel() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cancelled_.store(true);
+  if (client_) {
+    // The one cross-thread call httplib supports: shuts the socket down so the
+    // blocked request returns with an error.
+    client_->stop();
+  }
+}
+
+bool RequestControl::attach(HttpConnection* client) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (cancelled_.load()) {
+    return false;
+  }
+  client_ = client;
+  return true;
+}
+
+void RequestControl::detach() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  client_ = nullptr;
+}
+
 HttpAuthClient::HttpAuthClient(std::string baseUrl) {
   auto [host, port] = parseHostPort(baseUrl);
   host_ = host;
   port_ = port;
 }
 
+HttpAuthClient::~HttpAuthClient() {
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    stopping_ = true;
+    // Queued requests resolve as cancelled without touching the network.
+    for (const Task& task : queue_) {
+      task.control->cancel();
+    }
+    for (const auto& control : running_) {
+      control->cancel();
+    }
+  }
+  queueCv_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
 AuthResult HttpAuthClient::login(const std::string& username, const std::string& password) {
-  return submit("/v1/auth/login", username, password);
+  return submit("/v1/auth/login", username, password, nullptr);
 }
 
 AuthResult HttpAuthClient::reg(const std::string& username, const std::string& password) {
-  return submit("/v1/auth/register", username, password);
+  return submit("/v1/auth/register", username, password, nullptr);
 }
 
-AuthResult HttpAuthClient::submit(const std::string& path, const std::string& username,
-                                  const std::string& password) {
-  httplib::Client client(host_, port_);
-  client.set_connection_timeout(3, 0);
-  client.set_read_timeout(5, 0);
-  client.set_write_timeout(5, 0);
+CharacterList HttpAuthClient::fetchCharacters(const std::string& jwt, const std::string& etag,
+                                              const std::string& lastModified) {
+  return doFetchCharacters(jwt, etag, lastModified, nullptr);
+}
 
-  json request{{"email", username}, {"password", password}};
-  auto res = client.Post(path.c_str(), request.dump(), "application/json");
+std::optional<CharacterInfo> HttpAuthClient::createCharacter(const std::string& jwt, const std::string& name,
+                                                             const std::string& className) {
+  return doCreateCharacter(jwt, name, className, nullptr);
+}
+
+PendingRequest<AuthResult> HttpAuthClient::loginAsync(const std::string& username, const std::string& password) {
+  return enqueue([this, username, password](RequestControl* control) {
+    return submit("/v1/auth/login", username, password, control);
+  }, AuthResult{false, "", "Cancelled"});
+}
+
+PendingRequest<AuthResult> HttpAuthClient::regAsync(const std::string& username, const std::string& password) {
+  return enqueue([this, username, password](RequestControl* control) {
+    return submit("/v1/auth/register", username, password, control);
+  }, AuthResult{false, "", "Cancelled"});
+}
+
+PendingRequest<CharacterList> HttpAuthClient::fetchCharactersAsync(const std::string& jwt, const std::string& etag,
+                                                                   const std::string& lastModified) {
+  return enqueue([this, jwt, etag, lastModified](
+                     RequestControl* control) { return doFetchCharacters(jwt, etag, lastModified, control); },
+                 CharacterList{});
+}
+
+PendingRequest<std::optional<CharacterInfo>> HttpAuthClient::createCharacterAsync(const std::string& jwt,
+                                                                                  const std::string& name,
+                                                                                  const std::string& className) {
+  return enqueue([this, jwt, name, className](
+                     RequestControl* control) { return doCreateCharacter(jwt, name, className, control); },
+                 std::optional<CharacterInfo>{});
+}
+
+void HttpAuthClient::post(std::shared_ptr<RequestControl> control, std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (stopping_) {
+      control->cancel();
+    }
+    queue_.push_back(Task{std::move(control), std::move(task)});
+    if (workers_.size() < kWorkerCount && workers_.size() < queue_.size() + running_.size()) {
+      workers_.emplace_back([this]() { workerLoop(); });
+    }
+  }
+  queueCv_.notify_one();
+}
+
+void HttpAuthClient::workerLoop() {
+  std::unique_lock<std::mutex> lock(queueMutex_);
+  for (;;) {
+    queueCv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    Task task = std::move(queue_.front());
+    queue_.pop_front();
+    running_.push_back(task.control);
+    lock.unlock();
+    task.run();
+    lock.lock();
+    running_.erase(std::find(running_.begin(), running_.end(), task.control));
+  }
+}
+
+std::unique_ptr<HttpConnection> HttpAuthClient::acquireClient() {
+  {
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    if (!idleClients_.empty()) {
+      std::unique_ptr<HttpConnection> client = std::move(idleClients_.back());
+      idleClients_.pop_back();
+      return client;
+    }
+  }
+  auto client = std::make_unique<HttpConnection>(host_, port_);
+  client->set_keep_alive(true);
+  client->set_connection_timeout(3, 0);
+  client->set_read_timeout(5, 0);
+  client->set_write_timeout(5, 0);
+  return client;
+}
+
+void HttpAuthClient::releaseClient(std::unique_ptr<HttpConnection> client) {
+  // A client whose connection failed or was stopped reconnects on next use.
+  std::lock_guard<std::mutex> lock(clientsMutex_);
+  idleClients_.push_back(std::move(client));
+}
+
+bool HttpAuthClient::perform(httplib::Request& req, httplib::Response& res, RequestControl* control) {
+  std::unique_ptr<HttpConnection> client = acquireClient();
+  if (control && !control->attach(client.get())) {
+    releaseClient(std::move(client));
+    return false;
+  }
+
+  HttpTiming timing;
+  timing.method = req.method;
+  timing.path = req.path;
+  timing.reused = client->is_socket_open();
+  const auto start = Clock::now();
+  std::optional<Clock::time_point> socketAt;
+  std::optional<Clock::time_point> headersAt;
+  // Socket creation marks the end of name resolution; open() returns once
+  // the TCP handshake is done.
+  client->set_socket_options([&socketAt](socket_t) { socketAt = Clock::now(); });
+  req.response_handler = [&headersAt](const httplib::Response&) {
+    headersAt = Clock::now();
+    return true;
+  };
+
+  httplib::Error error = httplib::Error::Success;
+  bool ok = timing.reused || client->open(error);
+  const auto readyAt = Clock::now();
+  if (socketAt) {
+    timing.dnsMs = elapsedMs(start, *socketAt);
+    timing.connectMs = elapsedMs(*socketAt, readyAt);
+  }
+  ok = ok && client->send(req, res, error);
+  const auto end = Clock::now();
+  client->set_socket_options(nullptr);
+  if (control) {
+    control->detach();
+  }
+  releaseClient(std::move(client));
 
-  if (!res) {
+  timing.status = ok ? res.status : 0;
+  timing.ttfbMs = headersAt ? elapsedMs(readyAt, *headersAt) : -1.0;
+  timing.totalMs = elapsedMs(start, end);
+  {
+    std::lock_guard<std::mutex> lock(timingsMutex_);
+    if (timings_.size() >= kMaxTimings) {
+      timings_.pop_front();
+    }
+    timings_.push_back(timing);
+  }
+  return ok;
+}
+
+std::vector<HttpTiming> HttpAuthClient::takeTimings() {
+  std::lock_guard<std::mutex> lock(timingsMutex_);
+  std::vector<HttpTiming> out(timings_.begin(), timings_.end());
+  timings_.clear();
+  return out;
+}
+
+AuthResult HttpAuthClient::submit(const std::string& path, const std::string& username,
+                                  const std::string& password, RequestControl* control) {
+  json request{{"email", username}, {"password", password}};
+  httplib::Request req = makeRequest("POST", path, request.dump());
+  httplib::Response res;
+  if (!perform(req, res, control)) {
     return AuthResult{false, "", "Auth request failed"};
   }
 
-  if (res->status < 200 || res->status >= 300) {
+  if (res.status < 200 || res.status >= 300) {
     std::ostringstream oss;
-    oss << "Auth error HTTP " << res->status;
+    oss << "Auth error HTTP " << res.status;
     return AuthResult{false, "", oss.str()};
   }
 
   try {
-    json body = json::parse(res->body);
+    json body = json::parse(res.body);
     const std::string token = extractToken(body);
     if (token.empty()) {
       return AuthResult{false, "", "Auth succeeded but token not found"};
@@ -94,20 +312,35 @@ AuthResult HttpAuthClient::submit(const std::string& path, const std::string& us
   }
 }
 
-std::vector<CharacterInfo> HttpAuthClient::fetchCharacters(const std::string& jwt) {
-  std::vector<CharacterInfo> chars;
-  httplib::Client client(host_, port_);
-  client.set_connection_timeout(3, 0);
-  client.set_read_timeout(5, 0);
-
-  auto res = client.Get("/v1/characters", {{"Authorization", "Bearer " + jwt}});
-
-  if (!res || res->status != 200) {
+CharacterList HttpAuthClient::doFetchCharacters(const std::string& jwt, const std::string& etag,
+                                                const std::string& lastModified, RequestControl* control) {
+  CharacterList chars;
+  httplib::Request req = makeRequest("GET", "/v1/characters", {});
+  req.set_header("Authorization", "Bearer " + jwt);
+  if (!etag.empty()) {
+    req.set_header("If-None-Match", etag);
+  }
+  if (!lastModified.empty()) {
+    req.set_header("If-Modified-Since", lastModified);
+  }
+  httplib::Response res;
+  if (!perform(req, res, control)) {
+    return chars;
+  }
+  chars.status = res.status;
+  if (res.status == 304) {
+    chars.etag = etag;
+    chars.lastModified = lastModified;
     return chars;
   }
+  if (res.status != 200) {
+    return chars;
+  }
+  chars.etag = res.get_header_value("ETag");
+  chars.lastModified = res.get_header_value("Last-Modified");
 
   try {
-    json body = json::parse(res->body);
+    json body = json::parse(res.body);
     if (body.contains("items") && body["items"].is_array()) {
       for (const auto& item : body["items"]) {
         CharacterInfo ci;
@@ -115,7 +348,7 @@ std::vector<CharacterInfo> HttpAuthClient::fetchCharacters(const std::string& jw
         ci.name = item.value("name", "");
         ci.className = item.value("class", "");
         if (!ci.id.empty()) {
-          chars.push_back(ci);
+          chars.items.push_back(ci);
         }
       }
     }
@@ -125,22 +358,18 @@ std::vector<CharacterInfo> HttpAuthClient::fetchCharacters(const std::string& jw
   return chars;
 }
 
-std::optional<CharacterInfo> HttpAuthClient::createCharacter(const std::string& jwt, const std::string& name, const std::string& className) {
-  httplib::Client client(host_, port_);
-  client.set_connection_timeout(3, 0);
-  client.set_read_timeout(5, 0);
-  client.set_write_timeout(5, 0);
-
+std::optional<CharacterInfo> HttpAuthClient::doCreateCharacter(const std::string& jwt, const std::string& name,
+                                                               const std::string& className, RequestControl* control) {
   json request = {{"name", name}, {"class", className}};
-  httplib::Headers headers = {{"Authorization", "Bearer " + jwt}};
-  auto res = client.Post("/v1/characters", headers, request.dump(), "application/json");
-
-  if (!res || (res->status != 200 && res->status != 201)) {
+  httplib::Request req = makeRequest("POST", "/v1/characters", request.dump());
+  req.set_header("Authorization", "Bearer " + jwt);
+  httplib::Response res;
+  if (!perform(req, res, control) || (res.status != 200 && res.status != 201)) {
     return std::nullopt;
   }
 
   try {
-    json body = json::parse(res->body);
+    json body = json::parse(res.body);
     CharacterInfo ci;
     ci.id = body.value("id", "");
     ci.name = body.value("name", "");
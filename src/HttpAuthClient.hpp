@@ -1,8 +1,24 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
-#include <optional>
+
+namespace httplib {
+struct Request;
+struct Response;
+}  // namespace httplib
+
+class HttpConnection;
 
 struct AuthResult {
   bool ok = false;
@@ -16,17 +32,150 @@ struct CharacterInfo {
   std::string className;
 };
 
+struct CharacterList {
+  int status = 0;  // HTTP status; 0 when no response arrived, 304 when the cached list is current
+  std::vector<CharacterInfo> items;
+  // Validators for a conditional re-fetch.
+  std::string etag;
+  std::string lastModified;
+};
+
+// Per-request timings, in milliseconds.
+struct HttpTiming {
+  std::string method;
+  std::string path;
+  int status = 0;          // 0 when the request failed before a response
+  bool reused = false;     // went out on an already-open keep-alive connection
+  double dnsMs = 0.0;      // name resolution; 0 when reused
+  double connectMs = 0.0;  // TCP connect; 0 when reused
+  double ttfbMs = -1.0;    // from the connection being ready to response headers
+  double totalMs = 0.0;
+};
+
+// Shared between the caller and a request on the worker pool. cancel() may be
+// called from any thread: a queued request is skipped, one in flight has its
+// socket shut down.
+class RequestControl {
+ public:
+  void cancel();
+  bool cancelled() const { return cancelled_.load(); }
+
+ private:
+  friend class HttpAuthClient;
+  // False when the request was cancelled before it could start.
+  bool attach(HttpConnection* client);
+  void detach();
+
+  std::mutex mutex_;
+  std::atomic<bool> cancelled_{false};
+  HttpConnection* client_ = nullptr;
+};
+
+template <typename T>
+struct PendingRequest {
+  std::future<T> future;
+  std::shared_ptr<RequestControl> control;
+
+  bool active() const { return future.valid(); }
+  bool ready() const {
+    return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  }
+  // Only after ready(); leaves the request inactive.
+  T take() { return future.get(); }
+  void cancel() {
+    if (control) {
+      control->cancel();
+    }
+    future = {};
+  }
+};
+
+// The blocking calls run on the caller's thread. The *Async variants run the
+// same calls on a small worker pool (started on first use) and return at
+// once; a cancelled request resolves to a failure. Either way requests go out
+// over a pool of keep-alive connections to the one host, so login followed by
+// the character fetch pays for a single TCP handshake.
 class HttpAuthClient {
  public:
   explicit HttpAuthClient(std::string baseUrl);
+  ~HttpAuthClient();
+
+  HttpAuthClient(const HttpAuthClient&) = delete;
+  HttpAuthClient& operator=(const HttpAuthClient&) = delete;
 
   AuthResult login(const std::string& username, const std::string& password);
   AuthResult reg(const std::string& username, const std::string& password);
-  std::vector<CharacterInfo> fetchCharacters(const std::string& jwt);
+  // Also the cheap way to check that a stored token is still accepted. With
+  // validators from an earlier response the server may answer 304 instead of
+  // sending the list again.
+  CharacterList fetchCharacters(const std::string& jwt, const std::string& etag = {},
+                                const std::string& lastModified = {});
   std::optional<CharacterInfo> createCharacter(const std::string& jwt, const std::string& name, const std::string& className);
 
+  PendingRequest<AuthResult> loginAsync(const std::string& username, const std::string& password);
+  PendingRequest<AuthResult> regAsync(const std::string& username, const std::string& password);
+  PendingRequest<CharacterList> fetchCharactersAsync(const std::string& jwt, const std::string& etag = {},
+                                                     const std::string& lastModified = {});
+  PendingRequest<std::optional<CharacterInfo>> createCharacterAsync(const std::string& jwt, const std::string& name,
+                                                                   const std::string& className);
+
+  // Timings of requests completed since the last call (at most kMaxTimings).
+  std::vector<HttpTiming> takeTimings();
+
  private:
-  AuthResult submit(const std::string& path, const std::string& username, const std::string& password);
+  static constexpr std::size_t kWorkerCount = 2;
+  static constexpr std::size_t kMaxTimings = 32;
+
+  std::unique_ptr<HttpConnection> acquireClient();
+  void releaseClient(std::unique_ptr<HttpConnection> client);
+  // Sends `req` on a pooled connection and records its timing. False on a
+  // transport failure or cancellation.
+  bool perform(httplib::Request& req, httplib::Response& res, RequestControl* control);
+
+  AuthResult submit(const std::string& path, const std::string& username, const std::string& password,
+                    RequestControl* control);
+  CharacterList doFetchCharacters(const std::string& jwt, const std::string& etag, const std::string& lastModified,
+                                  RequestControl* control);
+  std::optional<CharacterInfo> doCreateCharacter(const std::string& jwt, const std::string& name,
+                                                 const std::string& className, RequestControl* control);
+
+  template <typename T, typename Fn>
+  PendingRequest<T> enqueue(Fn fn, T cancelledResult);
+  void post(std::shared_ptr<RequestControl> control, std::function<void()> task);
+  void workerLoop();
+
   std::string host_;
   int port_ = 80;
+
+  std::mutex clientsMutex_;
+  std::vector<std::unique_ptr<HttpConnection>> idleClients_;
+  std::mutex timingsMutex_;
+  std::deque<HttpTiming> timings_;
+
+  struct Task {
+    std::shared_ptr<RequestControl> control;
+    std::function<void()> run;
+  };
+  std::mutex queueMutex_;
+  std::condition_variable queueCv_;
+  std::deque<Task> queue_;
+  std::vector<std::shared_ptr<RequestControl>> running_;
+  std::vector<std::thread> workers_;
+  bool stopping_ = false;
 };
+
+template <typename T, typename Fn>
+PendingRequest<T> HttpAuthClient::enqueue(Fn fn, T cancelledResult) {
+  auto promise = std::make_shared<std::promise<T>>();
+  PendingRequest<T> request{promise->get_future(), std::make_shared<RequestControl>()};
+  post(request.control, [promise, control = request.control, fn = std::move(fn),
+                         cancelledResult = std::move(cancelledResult)]() mutable {
+    if (control->cancelled()) {
+      promise->set_value(std::move(cancelledResult));
+      return;
+    }
+    T result = fn(control.get());
+    promise->set_value(control->cancelled() ? std::move(cancelledResult) : std::move(result));
+  });
+  return request;
+}
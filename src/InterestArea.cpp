@@ -0,0 +1,28 @@
+#include "InterestArea.hpp"
+
+#include <algorithm>
+
+namespace {
+int floorToCell(int v, int cell) {
+  return (v >= 0 ? v / cell : (v - cell + 1) / cell) * cell;
+}
+}  // namespace
+
+std::optional<TileRect> InterestArea::update(const TileRect& visible, int mapWidth, int mapHeight) {
+  if (visible.empty() || mapWidth <= 0 || mapHeight <= 0) {
+    return std::nullopt;
+  }
+  const TileRect padded = visible.expanded(kMarginTiles);
+  TileRect area;
+  area.minX = std::max(0, floorToCell(padded.minX, kCellTiles));
+  area.minY = std::max(0, floorToCell(padded.minY, kCellTiles));
+  area.maxX = std::min(mapWidth - 1, floorToCell(padded.maxX, kCellTiles) + kCellTiles - 1);
+  area.maxY = std::min(mapHeight - 1, floorToCell(padded.maxY, kCellTiles) + kCellTiles - 1);
+  inner_ = visible;
+  if (active_ && area == area_) {
+    return std::nullopt;
+  }
+  active_ = true;
+  area_ = area;
+  return area_;
+}
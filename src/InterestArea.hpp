@@ -0,0 +1,76 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_set>
+
+// Inclusive tile bounds.
+struct TileRect {
+  int minX = 0;
+  int minY = 0;
+  int maxX = -1;
+  int maxY = -1;
+
+  bool empty() const { return maxX < minX || maxY < minY; }
+  bool contains(int x, int y) const { return x >= minX && x <= maxX && y >= minY && y <= maxY; }
+  TileRect expanded(int by) const { return TileRect{minX - by, minY - by, maxX + by, maxY + by}; }
+  int width() const { return maxX - minX + 1; }
+  int height() const { return maxY - minY + 1; }
+  bool operator==(const TileRect& o) const {
+    return minX == o.minX && minY == o.minY && maxX == o.maxX && maxY == o.maxY;
+  }
+  bool operator!=(const TileRect& o) const { return !(*this == o); }
+};
+
+// Client side of the `interest` subscription. The visible tiles plus a margin
+// are snapped outward to whole cells, so the area (and the message announcing
+// it) only changes when the camera crosses a cell boundary or the view is
+// resized. Once the server has acknowledged an area (`interest_ack`), it no
+// longer updates entities outside it: anything it reports leaving
+// (`interest_leave`), or last seen outside both that area and the current
+// one, is dropped locally. A server that never acknowledges keeps sending
+// everything, and nothing is evicted.
+class InterestArea {
+ public:
+  static constexpr int kCellTiles = 8;
+  static constexpr int kMarginTiles = 4;
+
+  // Returns the new area when it changed since the last call.
+  std::optional<TileRect> update(const TileRect& visible, int mapWidth, int mapHeight);
+
+  bool active() const { return active_; }
+  const TileRect& area() const { return area_; }
+  // Visible part of the area; the rest is the outer ring.
+  const TileRect& inner() const { return inner_; }
+
+  void acknowledge(const TileRect& area) {
+    acknowledged_ = true;
+    ackedArea_ = area;
+  }
+  bool acknowledged() const { return acknowledged_; }
+
+  bool shouldEvict(int x, int y) const {
+    return active_ && acknowledged_ && !area_.contains(x, y) && !ackedArea_.contains(x, y);
+  }
+
+  // Ids dropped by eviction. A partial update for one of these is expected
+  // (the server may not know we dropped it) rather than a lost baseline.
+  void noteEvicted(const std::string& id) { evicted_.insert(id); }
+  bool wasEvicted(const std::string& id) const { return evicted_.count(id) > 0; }
+  void clearEvicted() { evicted_.clear(); }
+
+  // Forgets the area so the next update() re-announces it (new connection).
+  // The new connection has to acknowledge it again before anything is evicted.
+  void reset() {
+    active_ = false;
+    acknowledged_ = false;
+  }
+
+ private:
+  bool active_ = false;
+  bool acknowledged_ = false;
+  TileRect area_;
+  TileRect ackedArea_;
+  TileRect inner_;
+  std::unordered_set<std::string> evicted_;
+};
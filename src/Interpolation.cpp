@@ -0,0 +1,110 @@
+#include "Interpolation.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void ClockSync::addSample(std::int64_t serverMs, std::int64_t localMs) {
+  window_.push_back(serverMs - localMs + rttMs_ / 2);
+  while (window_.size() > kWindow) {
+    window_.pop_front();
+  }
+  const std::int64_t best = *std::max_element(window_.begin(), window_.end());
+  if (!synced_ || std::llabs(best - offsetMs_) > kSnapThresholdMs) {
+    offsetMs_ = best;
+    synced_ = true;
+    return;
+  }
+  // Slew by a fraction, but always at least 1 ms so small drifts converge.
+  const std::int64_t diff = best - offsetMs_;
+  offsetMs_ += diff / 8 != 0 ? diff / 8 : (diff > 0) - (diff < 0);
+}
+
+void ClockSync::reset() {
+  window_.clear();
+  offsetMs_ = 0;
+  synced_ = false;
+}
+
+void SnapshotBuffer::record(const std::string& id, std::int64_t timeMs, float x, float y) {
+  auto& samples = histories_[id];
+  if (!samples.empty()) {
+    const Sample& last = samples.back();
+    if (timeMs < last.timeMs) {
+      return;  // late duplicate of something already superseded
+    }
+    if (std::hypot(x - last.x, y - last.y) > kTeleportDistance) {
+      samples.clear();
+    } else if (timeMs == last.timeMs) {
+      samples.back().x = x;
+      samples.back().y = y;
+      return;
+    }
+  }
+  samples.push_back(Sample{timeMs, x, y});
+  while (samples.size() > kMaxSamples) {
+    samples.pop_front();
+  }
+}
+
+namespace {
+float hermite(float p0, float p1, float m0, float m1, float u) {
+  const float u2 = u * u;
+  const float u3 = u2 * u;
+  return (2 * u3 - 3 * u2 + 1) * p0 + (u3 - 2 * u2 + u) * m0 + (-2 * u3 + 3 * u2) * p1 + (u3 - u2) * m1;
+}
+}  // namespace
+
+bool SnapshotBuffer::sample(const std::string& id, std::int64_t renderTimeMs, float& x, float& y) const {
+  const auto it = histories_.find(id);
+  if (it == histories_.end() || it->second.empty()) {
+    return false;
+  }
+  const auto& s = it->second;
+
+  if (s.size() == 1 || renderTimeMs <= s.front().timeMs) {
+    x = s.front().x;
+    y = s.front().y;
+    return true;
+  }
+
+  const Sample& last = s.back();
+  if (renderTimeMs >= last.timeMs) {
+    const Sample& prev = s[s.size() - 2];
+    const float span = static_cast<float>(std::max<std::int64_t>(1, last.timeMs - prev.timeMs));
+    const std::int64_t late = renderTimeMs - last.timeMs;
+    // Ramp out for the allowed window, then back to the last known position.
+    const std::int64_t ahead =
+        late <= kMaxExtrapolationMs ? late : std::max<std::int64_t>(0, 2 * kMaxExtrapolationMs - late);
+    const float t = static_cast<float>(ahead) / span;
+    x = last.x + (last.x - prev.x) * t;
+    y = last.y + (last.y - prev.y) * t;
+    return true;
+  }
+
+  // First sample newer than the render time; s.front() <= render < s[i].
+  std::size_t i = 1;
+  while (s[i].timeMs <= renderTimeMs) {
+    ++i;
+  }
+  const Sample& a = s[i - 1];
+  const Sample& b = s[i];
+  const float dt = static_cast<float>(b.timeMs - a.timeMs);
+  const float u = static_cast<float>(renderTimeMs - a.timeMs) / dt;
+
+  // Catmull-Rom tangents in "per segment" units, one-sided at the ends.
+  const auto tangent = [&](const Sample& from, const Sample& to, float Sample::*axis) {
+    const float span = static_cast<float>(to.timeMs - from.timeMs);
+    return (to.*axis - from.*axis) / span * dt;
+  };
+  const Sample& before = (i >= 2) ? s[i - 2] : a;
+  const Sample& after = (i + 1 < s.size()) ? s[i + 1] : b;
+  const auto axisValue = [&](float Sample::*axis) {
+    const float m0 = (&before == &a) ? tangent(a, b, axis) : tangent(before, b, axis);
+    const float m1 = (&after == &b) ? tangent(a, b, axis) : tangent(a, after, axis);
+    const float v = hermite(a.*axis, b.*axis, m0, m1, u);
+    return std::clamp(v, std::min(a.*axis, b.*axis), std::max(a.*axis, b.*axis));
+  };
+  x = axisValue(&Sample::x);
+  y = axisValue(&Sample::y);
+  return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+
+// Estimates server time from timestamped messages. Each sample gives
+// server - local (+ half the RTT); the largest value in a sliding window is
+// the one least inflated by queueing delay. Small corrections are slewed so
+// render time never jumps backwards; large ones (server restart) snap.
+class ClockSync {
+ public:
+  void addSample(std::int64_t serverMs, std::int64_t localMs);
+  void setRoundTripMs(std::int64_t rttMs) { rttMs_ = rttMs > 0 ? rttMs : 0; }
+  void reset();
+
+  bool synced() const { return synced_; }
+  std::int64_t offsetMs() const { return offsetMs_; }
+  // Without samples this is the identity, so local arrival times can stand in.
+  std::int64_t toServer(std::int64_t localMs) const { return localMs + offsetMs_; }
+
+ private:
+  static constexpr std::size_t kWindow = 32;
+  static constexpr std::int64_t kSnapThresholdMs = 500;
+
+  std::deque<std::int64_t> window_;
+  std::int64_t offsetMs_ = 0;
+  std::int64_t rttMs_ = 0;
+  bool synced_ = false;
+};
+
+// Per-entity position history, sampled at a render time behind the newest
+// data. Between samples it uses cubic Hermite interpolation (Catmull-Rom
+// tangents, clamped to the segment so grid moves never overshoot). Past the
+// newest sample it extrapolates for at most kMaxExtrapolationMs, then eases
+// back to the last known position.
+class SnapshotBuffer {
+ public:
+  static constexpr std::size_t kMaxSamples = 32;
+  static constexpr std::int64_t kMaxExtrapolationMs = 120;
+  static constexpr float kTeleportDistance = 4.0f;
+
+  void record(const std::string& id, std::int64_t timeMs, float x, float y);
+  bool sample(const std::string& id, std::int64_t renderTimeMs, float& x, float& y) const;
+  void erase(const std::string& id) { histories_.erase(id); }
+  void clear() { histories_.clear(); }
+
+  // Drops histories of entities no longer present in `live` (any map keyed by id).
+  template <typename Map>
+  void retain(const Map& live) {
+    if (histories_.size() <= live.size()) {
+      return;
+    }
+    for (auto it = histories_.begin(); it != histories_.end();) {
+      it = live.count(it->first) == 0 ? histories_.erase(it) : std::next(it);
+    }
+  }
+
+ private:
+  struct Sample {
+    std::int64_t timeMs = 0;
+    float x = 0.0f;
+    float y = 0.0f;
+  };
+
+  std::unordered_map<std::string, std::deque<Sample>> histories_;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Local move inputs the server has not acknowledged yet. Each outbound
+// `move` gets a sequence number; when an authoritative position for the local
+// player arrives, the inputs it has not seen are replayed on top of it.
+class MovePredictor {
+ public:
+  struct Input {
+    std::uint32_t seq = 0;
+    int dx = 0;
+    int dy = 0;
+    std::uint64_t sentAtMs = 0;
+  };
+
+  std::uint32_t record(int dx, int dy, std::uint64_t nowMs) {
+    const std::uint32_t seq = nextSeq_++;
+    pending_.push_back(Input{seq, dx, dy, nowMs});
+    // A server that never acks must not make the replay unbounded.
+    while (pending_.size() > kMaxPending) {
+      pending_.pop_front();
+    }
+    return seq;
+  }
+
+  // Drops every input the server reports as processed.
+  void acknowledge(std::uint32_t seq) {
+    while (!pending_.empty() && pending_.front().seq <= seq) {
+      pending_.pop_front();
+    }
+  }
+
+  // For servers without input acks: assume anything older than one round
+  // trip has been applied.
+  void acknowledgeSentBefore(std::uint64_t cutoffMs) {
+    while (!pending_.empty() && pending_.front().sentAtMs <= cutoffMs) {
+      pending_.pop_front();
+    }
+  }
+
+  const std::deque<Input>& pending() const { return pending_; }
+  // Sequence numbers keep increasing so late acks never match new inputs.
+  void clear() { pending_.clear(); }
+
+ private:
+  static constexpr std::size_t kMaxPending = 64;
+
+  std::deque<Input> pending_;
+  std::uint32_t nextSeq_ = 1;
+};
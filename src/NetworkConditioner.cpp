@@ -0,0 +1,65 @@
+#include "NetworkConditioner.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+std::string NetworkConditions::describe() const {
+  char buf[128];
+  std::snprintf(buf, sizeof(buf), "delay %dms, jitter %dms, drop %.1f%%, reorder %.1f%%", delayMs, jitterMs,
+                dropPercent, reorderPercent);
+  std::string text = buf;
+  text += bandwidthKbps > 0 ? ", bandwidth " + std::to_string(bandwidthKbps) + "kbps" : ", bandwidth unlimited";
+  if (disconnectEverySec > 0) {
+    text += ", disconnect every " + std::to_string(disconnectEverySec) + "s";
+  }
+  return text;
+}
+
+void NetworkConditioner::configure(const NetworkConditions& conditions) {
+  conditions_ = conditions;
+  reset();
+}
+
+void NetworkConditioner::reset() {
+  inbound_ = Lane{};
+  outbound_ = Lane{};
+}
+
+bool NetworkConditioner::roll(double percent) {
+  if (percent <= 0.0) {
+    return false;
+  }
+  std::uniform_real_distribution<double> dist(0.0, 100.0);
+  return dist(rng_) < percent;
+}
+
+std::optional<NetworkConditioner::Clock::time_point> NetworkConditioner::schedule(Direction direction,
+                                                                                  std::size_t bytes,
+                                                                                  Clock::time_point now) {
+  if (roll(conditions_.dropPercent)) {
+    return std::nullopt;
+  }
+  Lane& lane = (direction == Direction::Inbound) ? inbound_ : outbound_;
+
+  // Serialization: the link sends one message at a time at the capped rate.
+  Clock::time_point sentAt = now;
+  if (conditions_.bandwidthKbps > 0) {
+    const auto txTime = std::chrono::microseconds(static_cast<long long>(bytes) * 8000 / conditions_.bandwidthKbps);
+    sentAt = std::max(now, lane.linkFreeAt) + txTime;
+    lane.linkFreeAt = sentAt;
+  }
+
+  std::chrono::milliseconds latency(conditions_.delayMs);
+  if (conditions_.jitterMs > 0) {
+    std::uniform_int_distribution<int> dist(0, conditions_.jitterMs);
+    latency += std::chrono::milliseconds(dist(rng_));
+  }
+  Clock::time_point deliverAt = sentAt + latency;
+
+  // Like TCP, jitter alone never reorders; only the reorder roll may overtake.
+  if (!roll(conditions_.reorderPercent)) {
+    deliverAt = std::max(deliverAt, lane.lastDeliveryAt);
+    lane.lastDeliveryAt = deliverAt;
+  }
+  return deliverAt;
+}
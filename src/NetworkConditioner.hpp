@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <random>
+#include <string>
+
+// Synthetic bad-network parameters for the world socket. All zero = off.
+struct NetworkConditions {
+  int delayMs = 0;            // fixed one-way latency added in each direction
+  int jitterMs = 0;           // extra uniform [0, jitterMs] latency per message
+  double dropPercent = 0.0;   // messages discarded before delivery
+  double reorderPercent = 0.0;  // messages allowed to overtake earlier ones
+  int bandwidthKbps = 0;      // per-direction serialization cap, 0 = unlimited
+  int disconnectEverySec = 0;  // force-close an open connection after this long
+
+  bool active() const {
+    return delayMs > 0 || jitterMs > 0 || dropPercent > 0.0 || reorderPercent > 0.0 || bandwidthKbps > 0 ||
+           disconnectEverySec > 0;
+  }
+  std::string describe() const;
+};
+
+// Decides when (or whether) a message crosses the simulated link. Keeps
+// per-direction link state so bandwidth and FIFO ordering are modelled.
+// Not thread-safe; WebSocketClient uses it from the io thread only.
+class NetworkConditioner {
+ public:
+  using Clock = std::chrono::steady_clock;
+  enum class Direction { Inbound, Outbound };
+
+  void configure(const NetworkConditions& conditions);
+  const NetworkConditions& conditions() const { return conditions_; }
+  bool active() const { return conditions_.active(); }
+
+  // Delivery time for a message of `bytes` entering the link at `now`, or
+  // nullopt if it is dropped.
+  std::optional<Clock::time_point> schedule(Direction direction, std::size_t bytes, Clock::time_point now);
+  // Forget queued link state, e.g. on a new connection.
+  void reset();
+
+ private:
+  struct Lane {
+    Clock::time_point linkFreeAt{};
+    Clock::time_point lastDeliveryAt{};
+  };
+
+  bool roll(double percent);
+
+  NetworkConditions conditions_;
+  Lane inbound_;
+  Lane outbound_;
+  std::mt19937 rng_{std::random_device{}()};
+};
@@ -0,0 +1,39 @@
+#include "NetworkTelemetry.hpp"
+
+#include <algorithm>
+
+MessageTypeStats& NetworkTelemetry::entry(const std::string& type) {
+  if (type.empty()) {
+    return byType_["(untyped)"];
+  }
+  return byType_[type];
+}
+
+void NetworkTelemetry::recordInbound(const std::string& type, std::size_t bytes, std::uint64_t decodeNs,
+                                     std::uint64_t applyNs) {
+  MessageTypeStats& stats = entry(type);
+  ++stats.received;
+  stats.bytesIn += bytes;
+  stats.decodeNs += decodeNs;
+  stats.applyNs += applyNs;
+}
+
+void NetworkTelemetry::recordOutbound(const std::string& type, std::size_t bytes) {
+  MessageTypeStats& stats = entry(type);
+  ++stats.sent;
+  stats.bytesOut += bytes;
+}
+
+std::vector<std::pair<std::string, MessageTypeStats>> NetworkTelemetry::topByCost(std::size_t limit) const {
+  std::vector<std::pair<std::string, MessageTypeStats>> rows(byType_.begin(), byType_.end());
+  std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+    if (a.second.costNs() != b.second.costNs()) {
+      return a.second.costNs() > b.second.costNs();
+    }
+    return a.second.bytesIn + a.second.bytesOut > b.second.bytesIn + b.second.bytesOut;
+  });
+  if (rows.size() > limit) {
+    rows.resize(limit);
+  }
+  return rows;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Totals for one world message `type` since the last reset().
+struct MessageTypeStats {
+  std::uint64_t received = 0;
+  std::uint64_t sent = 0;
+  std::uint64_t bytesIn = 0;
+  std::uint64_t bytesOut = 0;
+  std::uint64_t decodeNs = 0;
+  std::uint64_t applyNs = 0;
+
+  std::uint64_t costNs() const { return decodeNs + applyNs; }
+};
+
+// Per-type message accounting. Main thread only: inbound entries are recorded
+// when a message is applied (decode time travels with the ring slot), outbound
+// ones when GameClient encodes a message.
+class NetworkTelemetry {
+ public:
+  void recordInbound(const std::string& type, std::size_t bytes, std::uint64_t decodeNs, std::uint64_t applyNs);
+  void recordOutbound(const std::string& type, std::size_t bytes);
+  // One drained batch in which UpdateCoalescer folded `updates` messages.
+  void recordFolded(std::size_t updates) {
+    ++foldedBatches_;
+    foldedUpdates_ += updates;
+  }
+  void reset() {
+    byType_.clear();
+    foldedBatches_ = 0;
+    foldedUpdates_ = 0;
+  }
+
+  const std::unordered_map<std::string, MessageTypeStats>& byType() const { return byType_; }
+  // Types sorted by decode+apply time, most expensive first.
+  std::vector<std::pair<std::string, MessageTypeStats>> topByCost(std::size_t limit) const;
+  std::uint64_t foldedBatches() const { return foldedBatches_; }
+  std::uint64_t foldedUpdates() const { return foldedUpdates_; }
+
+ private:
+  MessageTypeStats& entry(const std::string& type);
+
+  std::unordered_map<std::string, MessageTypeStats> byType_;
+  std::uint64_t foldedBatches_ = 0;
+  std::uint64_t foldedUpdates_ = 0;
+};
@@ -74,8 +74,17 @@ void Renderer3D::render(sf::RenderTarget& target, const WorldSnapshot& world, co
     spritesInitialized_ = true;
   }
 
-  sf::View worldView;
-  worldView.setSize(static_cast<float>(viewportWidth_) * cameraZoom_, static_cast<float>(viewportHeight_) * cameraZoom_);
+  target.setView(worldView(world));
+  drawTileLayer(target, world);
+  drawGrid(target, world);
+  drawEntities(target, world, font);
+  drawMinimap(target, world);
+  target.setView(target.getDefaultView());
+}
+
+sf::View Renderer3D::worldView(const WorldSnapshot& world) const {
+  sf::View view;
+  view.setSize(static_cast<float>(viewportWidth_) * cameraZoom_, static_cast<float>(viewportHeight_) * cameraZoom_);
 
   float localPx = static_cast<float>(world.width * world.tileSize) * 0.5f;
   float localPy = static_cast<float>(world.height * world.tileSize) * 0.5f;
@@ -87,18 +96,24 @@ void Renderer3D::render(sf::RenderTarget& target, const WorldSnapshot& world, co
 
   const float worldPixelWidth = static_cast<float>(world.width * world.tileSize);
   const float worldPixelHeight = static_cast<float>(world.height * world.tileSize);
-  const float halfW = worldView.getSize().x * 0.5f;
-  const float halfH = worldView.getSize().y * 0.5f;
+  const float halfW = view.getSize().x * 0.5f;
+  const float halfH = view.getSize().y * 0.5f;
   const float cx = std::clamp(localPx, halfW, std::max(halfW, worldPixelWidth - halfW));
   const float cy = std::clamp(localPy, halfH, std::max(halfH, worldPixelHeight - halfH));
-  worldView.setCenter(cx, cy);
+  view.setCenter(cx, cy);
+  return view;
+}
 
-  target.setView(worldView);
-  drawTileLayer(target, world);
-  drawGrid(target, world);
-  drawEntities(target, world, font);
-  drawMinimap(target, world);
-  target.setView(target.getDefaultView());
+sf::IntRect Renderer3D::visibleTiles(const WorldSnapshot& world) const {
+  const sf::View view = worldView(world);
+  const float tile = static_cast<float>(std::max(1, world.tileSize));
+  const int minX = std::max(0, static_cast<int>(std::floor((view.getCenter().x - view.getSize().x * 0.5f) / tile)));
+  const int minY = std::max(0, static_cast<int>(std::floor((view.getCenter().y - view.getSize().y * 0.5f) / tile)));
+  const int maxX =
+      std::min(world.width - 1, static_cast<int>(std::floor((view.getCenter().x + view.getSize().x * 0.5f) / tile)));
+  const int maxY =
+      std::min(world.height - 1, static_cast<int>(std::floor((view.getCenter().y + view.getSize().y * 0.5f) / tile)));
+  return sf::IntRect(minX, minY, std::max(0, maxX - minX + 1), std::max(0, maxY - minY + 1));
 }
 
 void Renderer3D::drawTileLayer(sf::RenderTarget& target, const WorldSnapshot& world) const {
@@ -15,8 +15,11 @@ class Renderer3D {
   void setCameraZoom(float zoom);
   float cameraZoom() const;
   void render(sf::RenderTarget& target, const WorldSnapshot& world, const sf::Font* font = nullptr);
+  // Tiles the next render() shows, clamped to the map.
+  sf::IntRect visibleTiles(const WorldSnapshot& world) const;
 
  private:
+  sf::View worldView(const WorldSnapshot& world) const;
   void drawTileLayer(sf::RenderTarget& target, const WorldSnapshot& world) const;
   void drawGrid(sf::RenderTarget& target, const WorldSnapshot& world) const;
   void drawEntities(sf::RenderTarget& target, const WorldSnapshot& world, const sf::Font* font) const;
@@ -0,0 +1,105 @@
+#include "SessionRecording.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+constexpr char kMagic[8] = {'M', 'M', 'R', 'P', 'R', 'E', 'C', '1'};
+constexpr std::uint32_t kMaxRecordBytes = 64u * 1024u * 1024u;
+
+template <typename T>
+void putLe(std::ofstream& out, T value) {
+  std::array<char, sizeof(T)> bytes{};
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    bytes[i] = static_cast<char>((static_cast<std::uint64_t>(value) >> (8 * i)) & 0xff);
+  }
+  out.write(bytes.data(), bytes.size());
+}
+
+template <typename T>
+bool getLe(std::ifstream& in, T& value) {
+  std::array<unsigned char, sizeof(T)> bytes{};
+  if (!in.read(reinterpret_cast<char*>(bytes.data()), bytes.size())) {
+    return false;
+  }
+  std::uint64_t v = 0;
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    v |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+  }
+  value = static_cast<T>(v);
+  return true;
+}
+}  // namespace
+
+bool SessionRecorder::open(const std::string& path) {
+  out_.open(path, std::ios::binary | std::ios::trunc);
+  if (!out_.is_open()) {
+    return false;
+  }
+  out_.write(kMagic, sizeof(kMagic));
+  out_.flush();
+  start_ = std::chrono::steady_clock::now();
+  lastFlush_ = start_;
+  records_ = 0;
+  return true;
+}
+
+void SessionRecorder::write(RecordKind kind, const std::string& payload) {
+  if (!out_.is_open()) {
+    return;
+  }
+  const auto now = std::chrono::steady_clock::now();
+  const auto elapsed = now - start_;
+  putLe(out_, static_cast<std::uint8_t>(kind));
+  putLe(out_, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+  putLe(out_, static_cast<std::uint32_t>(payload.size()));
+  out_.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+  ++records_;
+  if (now - lastFlush_ >= std::chrono::milliseconds(kFlushIntervalMs)) {
+    flush();
+  }
+}
+
+void SessionRecorder::flush() {
+  if (out_.is_open()) {
+    out_.flush();
+    lastFlush_ = std::chrono::steady_clock::now();
+  }
+}
+
+bool SessionReplayer::open(const std::string& path) {
+  in_.open(path, std::ios::binary);
+  if (!in_.is_open()) {
+    error_ = "cannot open " + path;
+    return false;
+  }
+  char magic[sizeof(kMagic)] = {};
+  if (!in_.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kMagic)) {
+    error_ = path + " is not a session recording";
+    return false;
+  }
+  return true;
+}
+
+bool SessionReplayer::next(SessionRecord& out) {
+  std::uint8_t kind = 0;
+  std::uint32_t length = 0;
+  if (!getLe(in_, kind)) {
+    return false;  // clean end of file
+  }
+  if (!getLe(in_, out.timeUs) || !getLe(in_, length)) {
+    truncatedTail_ = true;  // the recorder stopped mid-header
+    return false;
+  }
+  if (kind > 3 || length > kMaxRecordBytes) {
+    error_ = "corrupt record";
+    return false;
+  }
+  out.kind = static_cast<RecordKind>(kind);
+  out.payload.resize(length);
+  if (length > 0 && !in_.read(out.payload.data(), length)) {
+    truncatedTail_ = true;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// Append-only capture of a world session. File layout: the 8-byte magic
+// "MMRPREC1", then records of
+//   u8 kind | u64 microseconds since recording start | u32 length | payload
+// with integers little-endian.
+enum class RecordKind : std::uint8_t { InboundText = 0, InboundBinary = 1, OutboundText = 2, OutboundBinary = 3 };
+
+struct SessionRecord {
+  RecordKind kind = RecordKind::InboundText;
+  std::uint64_t timeUs = 0;
+  std::string payload;
+
+  bool inbound() const { return kind == RecordKind::InboundText || kind == RecordKind::InboundBinary; }
+  bool binary() const { return kind == RecordKind::InboundBinary || kind == RecordKind::OutboundBinary; }
+};
+
+// Not thread-safe. WebSocketClient writes from its io thread only. Records
+// reach the file at least every kFlushIntervalMs while traffic flows, and on
+// flush(), so a crash loses at most the last moments of a capture.
+class SessionRecorder {
+ public:
+  static constexpr int kFlushIntervalMs = 100;
+
+  bool open(const std::string& path);
+  bool isOpen() const { return out_.is_open(); }
+  void write(RecordKind kind, const std::string& payload);
+  void flush();
+  std::uint64_t records() const { return records_; }
+
+ private:
+  std::ofstream out_;
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::steady_clock::time_point lastFlush_;
+  std::uint64_t records_ = 0;
+};
+
+class SessionReplayer {
+ public:
+  bool open(const std::string& path);
+  // Reads the next record into `out`. False at end of file, on a corrupt
+  // record (see error()), or on a final record cut short by a crash while
+  // recording (see truncatedTail()); the records before it are intact.
+  bool next(SessionRecord& out);
+  const std::string& error() const { return error_; }
+  bool truncatedTail() const { return truncatedTail_; }
+
+ private:
+  std::ifstream in_;
+  std::string error_;
+  bool truncatedTail_ = false;
+};
@@ -0,0 +1,213 @@
+#include "SessionStore.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+std::string base64UrlDecode(const std::string& in) {
+  std::string out;
+  std::uint32_t buffer = 0;
+  int bits = 0;
+  for (const char c : in) {
+    int v = -1;
+    if (c >= 'A' && c <= 'Z') {
+      v = c - 'A';
+    } else if (c >= 'a' && c <= 'z') {
+      v = c - 'a' + 26;
+    } else if (c >= '0' && c <= '9') {
+      v = c - '0' + 52;
+    } else if (c == '-' || c == '+') {
+      v = 62;
+    } else if (c == '_' || c == '/') {
+      v = 63;
+    } else if (c == '=') {
+      break;
+    } else {
+      return {};
+    }
+    buffer = (buffer << 6) | static_cast<std::uint32_t>(v);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+    }
+  }
+  return out;
+}
+
+json readJsonFile(const std::filesystem::path& path) {
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    return json::object();
+  }
+  json doc = json::parse(in, nullptr, false);
+  return doc.is_object() ? doc : json::object();
+}
+
+bool writeOwnerOnly(const std::filesystem::path& path, const std::string& data) {
+#if defined(_WIN32)
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out << data;
+  return static_cast<bool>(out);
+#else
+  const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0) {
+    return false;
+  }
+  // The mode above only applies to a newly created file.
+  bool ok = ::fchmod(fd, 0600) == 0;
+  std::size_t written = 0;
+  while (ok && written < data.size()) {
+    const ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+    if (n <= 0) {
+      ok = false;
+      break;
+    }
+    written += static_cast<std::size_t>(n);
+  }
+  return ::close(fd) == 0 && ok;
+#endif
+}
+}  // namespace
+
+bool StoredSession::expired(std::int64_t marginSec) const {
+  if (expiresAt <= 0) {
+    return false;
+  }
+  const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+  return expiresAt <= now + marginSec;
+}
+
+std::optional<StoredSession> loadSession(const std::filesystem::path& path) {
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    return std::nullopt;
+  }
+  json doc;
+  try {
+    in >> doc;
+  } catch (...) {
+    return std::nullopt;
+  }
+  if (!doc.is_object() || !doc.contains("token") || !doc["token"].is_string()) {
+    return std::nullopt;
+  }
+  StoredSession session;
+  session.token = doc["token"].get<std::string>();
+  session.username = doc.value("username", "");
+  if (doc.contains("expires_at") && doc["expires_at"].is_number_integer()) {
+    session.expiresAt = doc["expires_at"].get<std::int64_t>();
+  }
+  if (session.token.empty()) {
+    return std::nullopt;
+  }
+  return session;
+}
+
+bool saveSession(const std::filesystem::path& path, const StoredSession& session) {
+  const json doc{
+      {"token", session.token},
+      {"username", session.username},
+      {"expires_at", session.expiresAt},
+  };
+  std::filesystem::path tmp = path;
+  tmp += ".tmp";
+  if (!writeOwnerOnly(tmp, doc.dump(2) + '\n')) {
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+    return false;
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  return !ec;
+}
+
+void clearSession(const std::filesystem::path& path) {
+  std::error_code ec;
+  std::filesystem::remove(path, ec);
+}
+
+std::optional<CharacterList> loadCachedCharacters(const std::filesystem::path& path, const std::string& user) {
+  const json doc = readJsonFile(path);
+  if (user.empty() || !doc.contains("users") || !doc["users"].is_object() || !doc["users"].contains(user)) {
+    return std::nullopt;
+  }
+  const json& entry = doc["users"][user];
+  if (!entry.is_object() || !entry.contains("items") || !entry["items"].is_array()) {
+    return std::nullopt;
+  }
+  CharacterList list;
+  list.status = 200;
+  list.etag = entry.value("etag", "");
+  list.lastModified = entry.value("last_modified", "");
+  for (const auto& item : entry["items"]) {
+    if (!item.is_object()) {
+      continue;
+    }
+    CharacterInfo ci;
+    ci.id = item.value("id", "");
+    ci.name = item.value("name", "");
+    ci.className = item.value("class", "");
+    if (!ci.id.empty()) {
+      list.items.push_back(ci);
+    }
+  }
+  return list;
+}
+
+void saveCachedCharacters(const std::filesystem::path& path, const std::string& user, const CharacterList& list) {
+  if (user.empty()) {
+    return;
+  }
+  json doc = readJsonFile(path);
+  if (!doc.contains("users") || !doc["users"].is_object()) {
+    doc["users"] = json::object();
+  }
+  json items = json::array();
+  for (const CharacterInfo& ci : list.items) {
+    items.push_back({{"id", ci.id}, {"name", ci.name}, {"class", ci.className}});
+  }
+  doc["users"][user] = {{"etag", list.etag}, {"last_modified", list.lastModified}, {"items", std::move(items)}};
+
+  std::filesystem::path tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    if (!out.is_open()) {
+      return;
+    }
+    out << doc.dump(2) << '\n';
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+}
+
+std::int64_t jwtExpiry(const std::string& token) {
+  const auto first = token.find('.');
+  const auto second = first == std::string::npos ? std::string::npos : token.find('.', first + 1);
+  if (second == std::string::npos) {
+    return 0;
+  }
+  try {
+    const json claims = json::parse(base64UrlDecode(token.substr(first + 1, second - first - 1)));
+    if (claims.is_object() && claims.contains("exp") && claims["exp"].is_number()) {
+      return claims["exp"].get<std::int64_t>();
+    }
+  } catch (...) {
+    // payload is not JSON: treat as no expiry
+  }
+  return 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "HttpAuthClient.hpp"
+
+// Login token kept between launches in `session.json` next to settings.json.
+// The file holds a bearer credential, so on POSIX it is written owner-only
+// (0600) and replaced atomically.
+struct StoredSession {
+  std::string token;
+  std::string username;
+  std::int64_t expiresAt = 0;  // unix seconds from the JWT `exp` claim; 0 if unknown
+
+  // True when the token is known to expire within `marginSec`.
+  bool expired(std::int64_t marginSec) const;
+};
+
+std::optional<StoredSession> loadSession(const std::filesystem::path& path);
+bool saveSession(const std::filesystem::path& path, const StoredSession& session);
+void clearSession(const std::filesystem::path& path);
+
+// Last character list per user, with its validators, in
+// `characters_cache.json`. Shown at once on the next login while a
+// conditional GET revalidates it.
+std::optional<CharacterList> loadCachedCharacters(const std::filesystem::path& path, const std::string& user);
+void saveCachedCharacters(const std::filesystem::path& path, const std::string& user, const CharacterList& list);
+
+// `exp` from the payload of a JWT, or 0 if the token is not a JWT or has none.
+std::int64_t jwtExpiry(const std::string& token);
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single-producer/single-consumer ring. Slots are allocated once and
+// reused, so a producer that fills a slot in place (e.g. std::string::assign)
+// stops allocating once the ring has warmed up.
+template <typename T>
+class SpscRing {
+ public:
+  class View {
+   public:
+    class iterator {
+     public:
+      iterator(const View* view, std::size_t index) : view_(view), index_(index) {}
+      T& operator*() const { return (*view_)[index_]; }
+      T* operator->() const { return &(*view_)[index_]; }
+      iterator& operator++() {
+        ++index_;
+        return *this;
+      }
+      bool operator!=(const iterator& rhs) const { return index_ != rhs.index_; }
+      bool operator==(const iterator& rhs) const { return index_ == rhs.index_; }
+
+     private:
+      const View* view_;
+      std::size_t index_;
+    };
+
+    View() = default;
+
+    std::size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    T& operator[](std::size_t i) const { return ring_->slots_[(start_ + i) & ring_->mask_]; }
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, count_); }
+
+   private:
+    friend class SpscRing;
+    View(SpscRing* ring, std::size_t start, std::size_t count) : ring_(ring), start_(start), count_(count) {}
+
+    SpscRing* ring_ = nullptr;
+    std::size_t start_ = 0;
+    std::size_t count_ = 0;
+  };
+
+  explicit SpscRing(std::size_t minCapacity) {
+    std::size_t capacity = 2;
+    while (capacity < minCapacity) {
+      capacity <<= 1;
+    }
+    slots_.resize(capacity);
+    mask_ = capacity - 1;
+  }
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  std::size_t capacity() const { return slots_.size(); }
+
+  // Approximate from either side; exact only when called by the consumer.
+  std::size_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  // Producer side. `fill(T&)` writes the message into a recycled slot.
+  template <typename Fill>
+  bool tryPush(Fill&& fill) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head - cachedTail_ >= slots_.size()) {
+      cachedTail_ = tail_.load(std::memory_order_acquire);
+      if (head - cachedTail_ >= slots_.size()) {
+        return false;
+      }
+    }
+    fill(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. The returned view stays valid until release() is called;
+  // the producer never touches slots inside it.
+  View acquire() {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    const std::size_t head = head_.load(std::memory_order_acquire);
+    return View(this, tail, head - tail);
+  }
+
+  void release(const View& view) {
+    tail_.store(view.start_ + view.count_, std::memory_order_release);
+  }
+
+ private:
+  static constexpr std::size_t kCacheLine = 64;
+
+  std::vector<T> slots_;
+  std::size_t mask_ = 0;
+
+  alignas(kCacheLine) std::atomic<std::size_t> head_{0};
+  std::size_t cachedTail_ = 0;  // producer-private copy of tail_
+  alignas(kCacheLine) std::atomic<std::size_t> tail_{0};
+};
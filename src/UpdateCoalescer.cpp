@@ -0,0 +1,74 @@
+#include "UpdateCoalescer.hpp"
+
+#include <algorithm>
+#include <variant>
+
+std::size_t UpdateCoalescer::fold(const WebSocketClient::InboundView& view, const WebSocketClient& client) {
+  if (view.size() < kMinBacklog) {
+    return 0;
+  }
+
+  newerPlayers_.clear();
+  newerMobs_.clear();
+  std::size_t folded = 0;
+
+  // Walk newest to oldest: an id is in newer*_ when a later update will
+  // overwrite it without an ordering barrier in between.
+  for (std::size_t i = view.size(); i-- > 0;) {
+    InboundMessage& msg = view[i];
+    if (!client.isCurrent(msg) || !msg.isDecoded) {
+      continue;
+    }
+    WorldEvent& event = msg.decoded.event;
+
+    if (auto* ev = std::get_if<PlayerUpsert>(&event)) {
+      if (ev->joined) {
+        newerPlayers_.erase(ev->player.id);
+      } else if (!newerPlayers_.insert(ev->player.id).second) {
+        event = std::monostate{};
+        ++folded;
+      }
+    } else if (auto* ev = std::get_if<MobUpsert>(&event)) {
+      auto& mobs = ev->mobs;
+      const std::size_t before = mobs.size();
+      // Reverse so the last entry for a duplicated id wins within one message too.
+      std::reverse(mobs.begin(), mobs.end());
+      mobs.erase(std::remove_if(mobs.begin(), mobs.end(),
+                                [this](const MobState& mob) { return !newerMobs_.insert(mob.id).second; }),
+                 mobs.end());
+      std::reverse(mobs.begin(), mobs.end());
+      folded += before - mobs.size();
+      if (mobs.empty()) {
+        event = std::monostate{};
+      }
+    } else if (const auto* ev = std::get_if<WorldDelta>(&event)) {
+      // A partial delta needs the earlier full state of the entities it touches.
+      for (const auto& d : ev->players) {
+        newerPlayers_.erase(d.id);
+      }
+      for (const auto& d : ev->mobs) {
+        newerMobs_.erase(d.id);
+      }
+    } else if (const auto* ev = std::get_if<PlayerLeft>(&event)) {
+      newerPlayers_.erase(ev->id);
+    } else if (const auto* ev = std::get_if<InterestLeave>(&event)) {
+      for (const auto& id : ev->players) {
+        newerPlayers_.erase(id);
+      }
+      for (const auto& id : ev->mobs) {
+        newerMobs_.erase(id);
+      }
+    } else if (const auto* ev = std::get_if<PlayerDied>(&event)) {
+      newerPlayers_.erase(ev->id);
+    } else if (const auto* ev = std::get_if<Combat>(&event)) {
+      // Combat reads the target's position and HP, so the update it sees must stay.
+      newerPlayers_.erase(ev->targetId);
+      newerMobs_.erase(ev->targetId);
+    } else if (std::holds_alternative<Welcome>(event) || std::holds_alternative<Resumed>(event)) {
+      newerPlayers_.clear();
+      newerMobs_.clear();
+    }
+  }
+
+  return folded;
+}
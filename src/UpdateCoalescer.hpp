@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+#include "WebSocketClient.hpp"
+
+// Folds superseded entity updates out of a drained batch before it is applied.
+// A non-join PlayerUpsert or a MobUpsert entry is dropped when a later message
+// in the same batch upserts the same id with nothing order-sensitive for that
+// entity (join/leave, combat, death, world_delta, welcome/resumed) in between. Upserts
+// replace the whole entity, so applying only the last one yields the same state.
+// Everything else is left untouched and in order.
+class UpdateCoalescer {
+ public:
+  // Below this many queued messages the batch is applied as-is.
+  static constexpr std::size_t kMinBacklog = 16;
+
+  // Messages must already be decoded. Folded messages become std::monostate
+  // (their `seq` is kept). Returns the number of entity updates dropped.
+  std::size_t fold(const WebSocketClient::InboundView& view, const WebSocketClient& client);
+
+ private:
+  std::unordered_set<std::string> newerPlayers_;
+  std::unordered_set<std::string> newerMobs_;
+};
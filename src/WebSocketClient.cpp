@@ -1,106 +1,422 @@
 #include "WebSocketClient.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <utility>
 
+#include "WorldProtocol.hpp"
+
+namespace {
+const char* closeStatusText(bool autoReconnect) {
+  return autoReconnect ? "World socket closed, reconnecting" : "World socket closed";
+}
+}  // namespace
+
 WebSocketClient::WebSocketClient() {
   client_.clear_access_channels(websocketpp::log::alevel::all);
   client_.clear_error_channels(websocketpp::log::elevel::all);
   client_.init_asio();
   client_.start_perpetual();
 
+  // Handlers run on the io thread. Events from a connection that has since
+  // been replaced or abandoned are ignored.
   client_.set_open_handler([this](websocketpp::connection_hdl hdl) {
-    hdl_ = hdl;
-    connected_.store(true);
-    setStatus("Connected to world socket");
+    if (!isActive(hdl)) {
+      return;
+    }
+    auto con = client_.get_con_from_hdl(hdl);
+    const std::string extensions = con->get_response_header("Sec-WebSocket-Extensions");
+    compressionActive_.store(extensions.find("permessage-deflate") != std::string::npos);
+    openGeneration_.store(activeGeneration_);
+    connectionId_.fetch_add(1);
+    state_.store(ConnectionState::Open);
+    setStatus(compressionActive_.load() ? "Connected to world socket (deflate)" : "Connected to world socket");
+    missedPongs_ = 0;
+    schedulePing(connectionId_.load());
+    if (conditioner_.conditions().disconnectEverySec > 0) {
+      scheduleForcedDisconnect(connectionId_.load());
+    }
   });
 
-  client_.set_close_handler([this](websocketpp::connection_hdl) {
-    connected_.store(false);
-    setStatus("World socket closed");
+  client_.set_pong_handler([this](websocketpp::connection_hdl hdl, std::string payload) {
+    if (!isActive(hdl)) {
+      return;
+    }
+    missedPongs_ = 0;
+    if (conditioner_.active()) {
+      // Held like any inbound frame, so the RTT includes the simulated latency.
+      const auto at = conditioner_.schedule(NetworkConditioner::Direction::Inbound, payload.size(),
+                                            NetworkConditioner::Clock::now());
+      if (at) {
+        queueDelayed(*at, DelayedFrame{payload, false, true, connectionId_.load(), {}, true});
+      }
+      return;
+    }
+    handlePong(payload);
+  });
+
+  client_.set_pong_timeout_handler([this](websocketpp::connection_hdl hdl, std::string) {
+    if (isActive(hdl)) {
+      handlePongTimeout();
+    }
+  });
+
+  client_.set_close_handler([this](websocketpp::connection_hdl hdl) {
+    if (finishClosing(hdl) || !isActive(hdl)) {
+      return;
+    }
+    handleDrop(closeStatusText(autoReconnect_.load()));
   });
 
   client_.set_fail_handler([this](websocketpp::connection_hdl hdl) {
-    connected_.store(false);
+    if (finishClosing(hdl) || !isActive(hdl)) {
+      return;
+    }
     auto con = client_.get_con_from_hdl(hdl);
-    setStatus(std::string("WebSocket fail: ") + con->get_ec().message());
+    handleDrop(std::string("WebSocket fail: ") + con->get_ec().message());
   });
 
   client_.set_message_handler(
-      [this](websocketpp::connection_hdl, Client::message_ptr msg) {
-        std::lock_guard<std::mutex> lock(queueMutex_);
-        inbound_.push_back(msg->get_payload());
+      [this](websocketpp::connection_hdl hdl, Client::message_ptr msg) {
+        if (!isActive(hdl)) {
+          return;
+        }
+        missedPongs_ = 0;  // the link is alive even if a pong is stuck behind this frame
+        auto& counters = hooks_.counters;
+        counters.payloadIn.fetch_add(msg->get_payload().size());
+        if (!msg->get_compressed()) {
+          // Compressed frames are counted by the deflate extension.
+          counters.wireIn.fetch_add(msg->get_payload().size());
+        }
+        const bool binary = msg->get_opcode() == websocketpp::frame::opcode::binary;
+        if (conditioner_.active()) {
+          const auto at = conditioner_.schedule(NetworkConditioner::Direction::Inbound, msg->get_payload().size(),
+                                                NetworkConditioner::Clock::now());
+          if (!at) {
+            conditionerDropped_.fetch_add(1);
+            return;
+          }
+          queueDelayed(*at, DelayedFrame{{}, binary, true, connectionId_.load(), msg});
+          return;
+        }
+        pushInbound(msg, binary);
       });
+
+  thread_ = std::thread([this]() {
+    boundSocketHooks() = &hooks_;
+    // run() can be re-entered after a handler throws; it returns normally
+    // only once the destructor stops the endpoint.
+    for (;;) {
+      try {
+        client_.run();
+        return;
+      } catch (const std::exception& e) {
+        setStatus(std::string("WebSocket exception: ") + e.what());
+      }
+    }
+  });
 }
 
 WebSocketClient::~WebSocketClient() {
-  disconnect();
+  autoReconnect_.store(false);
+  websocketpp::lib::asio::post(client_.get_io_service(), [this]() {
+    cancelReconnect();
+    closeActive(websocketpp::close::status::going_away, "bye");
+    client_.stop();
+  });
+  client_.stop_perpetual();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
 }
 
 bool WebSocketClient::connect(const std::string& url, const std::string& jwt) {
-  disconnect();
+  const std::uint32_t generation = generation_.fetch_add(1) + 1;
+  {
+    std::lock_guard<std::mutex> lock(outboundMutex_);
+    outbound_.clear();
+  }
   setStatus("Connecting...");
 
-  std::string wsUrl = url;
-  if (!jwt.empty()) {
+  websocketpp::lib::asio::post(client_.get_io_service(), [this, url, jwt, generation]() {
+    if (generation != generation_.load()) {
+      return;  // superseded by a later connect/disconnect
+    }
+    activeGeneration_ = generation;
+    url_ = url;
+    jwt_ = jwt;
+    backoff_.reset();
+    cancelReconnect();
+    openConnection();
+  });
+  return true;
+}
+
+void WebSocketClient::disconnect() {
+  generation_.fetch_add(1);
+  {
+    std::lock_guard<std::mutex> lock(outboundMutex_);
+    outbound_.clear();
+  }
+  setStatus("Disconnected");
+
+  websocketpp::lib::asio::post(client_.get_io_service(), [this]() {
+    cancelReconnect();
+    closeActive(websocketpp::close::status::normal, "bye");
+  });
+}
+
+void WebSocketClient::resetReconnectBackoff() {
+  websocketpp::lib::asio::post(client_.get_io_service(), [this]() { backoff_.reset(); });
+}
+
+bool WebSocketClient::isActive(websocketpp::connection_hdl hdl) const {
+  return !hdl.owner_before(hdl_) && !hdl_.owner_before(hdl) && !hdl_.expired();
+}
+
+void WebSocketClient::openConnection() {
+  closeActive(websocketpp::close::status::normal, "reconnect");
+
+  std::string wsUrl = url_;
+  if (!jwt_.empty()) {
     wsUrl += (wsUrl.find('?') == std::string::npos) ? "?" : "&";
-    wsUrl += "token=" + jwt;
+    wsUrl += "token=" + jwt_;
   }
 
   websocketpp::lib::error_code ec;
   auto con = client_.get_connection(wsUrl, ec);
   if (ec) {
+    state_.store(ConnectionState::Idle);
     setStatus(std::string("Connection build failed: ") + ec.message());
-    return false;
+    return;
   }
 
-  if (!jwt.empty()) {
-    con->append_header("Authorization", "Bearer " + jwt);
+  if (!jwt_.empty()) {
+    con->append_header("Authorization", "Bearer " + jwt_);
   }
+  // websocketpp restarts the timeout on every ping, so a longer one would never fire.
+  con->set_pong_timeout(std::min(heartbeat_.pongTimeoutMs, heartbeat_.intervalMs));
 
+  hooks_.counters.reset();
+  compressionActive_.store(false);
+  conditioner_.reset();
+  delayed_.clear();
+  rttUs_.store(-1);
+  smoothedRttUs_.store(-1);
+  hdl_ = con->get_handle();
+  state_.store(ConnectionState::Connecting);
+  setStatus("Connecting...");
   client_.connect(con);
+}
 
-  running_.store(true);
-  thread_ = std::thread([this]() {
-    try {
-      client_.run();
-    } catch (const std::exception& e) {
-      setStatus(std::string("WebSocket exception: ") + e.what());
+void WebSocketClient::closeActive(websocketpp::close::status::value code, const std::string& reason) {
+  if (pingTimer_) {
+    pingTimer_->cancel();
+    pingTimer_.reset();
+  }
+  flushing_.clear();
+  flushScheduled_.store(false);
+  delayed_.clear();
+  if (recorder_) {
+    recorder_->flush();
+  }
+  if (hdl_.expired()) {
+    hdl_.reset();
+    state_.store(ConnectionState::Idle);
+    return;
+  }
+  // The close handshake completes in the background. Only `closing_` still
+  // matches its handlers, so a connect() issued meanwhile is not held up.
+  websocketpp::lib::error_code ec;
+  client_.close(hdl_, code, reason, ec);
+  closing_ = ec ? websocketpp::connection_hdl() : hdl_;
+  hdl_.reset();
+  state_.store(closing_.expired() ? ConnectionState::Idle : ConnectionState::Closing);
+}
+
+bool WebSocketClient::finishClosing(websocketpp::connection_hdl hdl) {
+  if (hdl.owner_before(closing_) || closing_.owner_before(hdl) || closing_.expired()) {
+    return false;
+  }
+  closing_.reset();
+  if (state_.load() == ConnectionState::Closing) {
+    state_.store(ConnectionState::Idle);
+  }
+  return true;
+}
+
+void WebSocketClient::handleDrop(const std::string& status) {
+  hdl_.reset();
+  // The main thread's last_seq only covers what it has applied. Anything
+  // still queued from this socket is left for the resume to replay, so it
+  // cannot be applied twice.
+  spill_.clear();
+  spillDepth_.store(0);
+  firstLiveConnectionId_.store(connectionId_.load() + 1);
+  if (recorder_) {
+    recorder_->flush();
+  }
+  if (pingTimer_) {
+    pingTimer_->cancel();
+    pingTimer_.reset();
+  }
+  compressionActive_.store(false);
+  if (!autoReconnect_.load() || activeGeneration_ != generation_.load()) {
+    state_.store(ConnectionState::Idle);
+    setStatus(status);
+    return;
+  }
+
+  const std::uint32_t delayMs = backoff_.nextDelayMs();
+  state_.store(ConnectionState::Backoff);
+  setStatus(status + " (retry in " + std::to_string((delayMs + 500) / 1000) + "s)");
+  const std::uint32_t generation = activeGeneration_;
+  reconnectTimer_ = client_.set_timer(delayMs, [this, generation](const websocketpp::lib::error_code& ec) {
+    if (ec || generation != generation_.load() || state_.load() != ConnectionState::Backoff) {
+      return;
     }
-    running_.store(false);
+    reconnectTimer_.reset();
+    openConnection();
   });
+}
 
-  return true;
+void WebSocketClient::cancelReconnect() {
+  if (reconnectTimer_) {
+    reconnectTimer_->cancel();
+    reconnectTimer_.reset();
+  }
+  if (state_.load() == ConnectionState::Backoff) {
+    state_.store(ConnectionState::Idle);
+  }
 }
 
-void WebSocketClient::disconnect() {
-  connected_.store(false);
+void WebSocketClient::setHeartbeat(const HeartbeatOptions& options) {
+  websocketpp::lib::asio::post(client_.get_io_service(), [this, options]() { heartbeat_ = options; });
+}
 
-  if (thread_.joinable()) {
-    websocketpp::lib::error_code ec;
-    client_.close(hdl_, websocketpp::close::status::normal, "bye", ec);
-    client_.stop_perpetual();
-    client_.stop();
-    thread_.join();
+void WebSocketClient::schedulePing(std::uint32_t connectionId) {
+  pingTimer_ = client_.set_timer(heartbeat_.intervalMs, [this, connectionId](const websocketpp::lib::error_code& ec) {
+    if (ec || state_.load() != ConnectionState::Open || connectionId != connectionId_.load()) {
+      return;
+    }
+    // The payload is echoed back in the pong, so no per-ping state is needed.
+    const auto sentAt = std::chrono::steady_clock::now();
+    const std::string payload =
+        std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(sentAt.time_since_epoch()).count());
+    if (conditioner_.active()) {
+      const auto at = conditioner_.schedule(NetworkConditioner::Direction::Outbound, payload.size(), sentAt);
+      if (at) {
+        queueDelayed(*at, DelayedFrame{payload, false, false, connectionId, {}, true});
+      }
+    } else {
+      sendPing(payload);
+    }
+    if (recorder_) {
+      recorder_->flush();  // lands the tail of a capture that has gone quiet
+    }
+    schedulePing(connectionId);
+  });
+}
 
-    client_.reset();
-    client_.start_perpetual();
+void WebSocketClient::handlePongTimeout() {
+  if (state_.load() != ConnectionState::Open || ++missedPongs_ < std::max(1, heartbeat_.maxMissed)) {
+    return;
+  }
+  // A half-open TCP connection never reports an error by itself. The close
+  // handshake cannot complete either; it times out in the background while
+  // handleDrop() schedules the reconnect.
+  heartbeatTimeouts_.fetch_add(1);
+  closeActive(websocketpp::close::status::going_away, "heartbeat timeout");
+  handleDrop(autoReconnect_.load() ? "World socket heartbeat lost, reconnecting" : "World socket heartbeat lost");
+}
+
+void WebSocketClient::sendPing(const std::string& payload) {
+  websocketpp::lib::error_code ec;
+  client_.ping(hdl_, payload, ec);
+}
+
+void WebSocketClient::handlePong(const std::string& payload) {
+  std::int64_t sentUs = 0;
+  try {
+    sentUs = std::stoll(payload);
+  } catch (const std::exception&) {
+    return;  // unsolicited pong
+  }
+  const auto now = std::chrono::steady_clock::now().time_since_epoch();
+  const std::int64_t rtt = std::chrono::duration_cast<std::chrono::microseconds>(now).count() - sentUs;
+  if (rtt < 0) {
+    return;
+  }
+  rttUs_.store(rtt);
+  const std::int64_t smoothed = smoothedRttUs_.load();
+  smoothedRttUs_.store(smoothed < 0 ? rtt : smoothed + (rtt - smoothed) / 8);
+}
+
+bool WebSocketClient::send(const std::string& payload, bool binary, const std::string& coalesceKey) {
+  if (!isConnected()) {
+    return false;
   }
 
   {
-    std::lock_guard<std::mutex> lock(queueMutex_);
-    inbound_.clear();
+    std::lock_guard<std::mutex> lock(outboundMutex_);
+    if (!coalesceKey.empty() && !outbound_.empty() && outbound_.back().coalesceKey == coalesceKey) {
+      outbound_.back().payload = payload;
+      outbound_.back().binary = binary;
+      coalescedOutbound_.fetch_add(1);
+    } else {
+      outbound_.push_back(OutboundMessage{payload, binary, coalesceKey});
+    }
   }
 
-  setStatus("Disconnected");
+  if (!flushScheduled_.exchange(true)) {
+    websocketpp::lib::asio::post(client_.get_io_service(), [this]() { flushOutbound(); });
+  }
+  return true;
 }
 
-bool WebSocketClient::sendText(const std::string& payload) {
-  if (!connected_.load()) {
-    return false;
+void WebSocketClient::flushOutbound() {
+  // Clear first so anything queued after the swap schedules its own flush.
+  flushScheduled_.store(false);
+  {
+    std::lock_guard<std::mutex> lock(outboundMutex_);
+    flushing_.swap(outbound_);
+  }
+
+  if (state_.load() != ConnectionState::Open) {
+    flushing_.clear();
+    return;
+  }
+
+  auto& counters = hooks_.counters;
+  const bool compressed = compressionActive_.load();
+  for (const auto& msg : flushing_) {
+    if (recorder_) {
+      recorder_->write(msg.binary ? RecordKind::OutboundBinary : RecordKind::OutboundText, msg.payload);
+    }
+    counters.payloadOut.fetch_add(msg.payload.size());
+    if (!compressed) {
+      counters.wireOut.fetch_add(msg.payload.size());
+    }
+    if (conditioner_.active()) {
+      const auto at = conditioner_.schedule(NetworkConditioner::Direction::Outbound, msg.payload.size(),
+                                            NetworkConditioner::Clock::now());
+      if (!at) {
+        conditionerDropped_.fetch_add(1);
+        continue;
+      }
+      queueDelayed(*at, DelayedFrame{msg.payload, msg.binary, false, connectionId_.load(), {}});
+      continue;
+    }
+    if (!sendNow(msg.payload, msg.binary)) {
+      break;
+    }
   }
+  flushing_.clear();
+}
 
+bool WebSocketClient::sendNow(const std::string& payload, bool binary) {
   websocketpp::lib::error_code ec;
-  client_.send(hdl_, payload, websocketpp::frame::opcode::text, ec);
+  client_.send(hdl_, payload, binary ? websocketpp::frame::opcode::binary : websocketpp::frame::opcode::text, ec);
   if (ec) {
     setStatus(std::string("Send failed: ") + ec.message());
     return false;
@@ -108,15 +424,163 @@ bool WebSocketClient::sendText(const std::string& payload) {
   return true;
 }
 
-std::vector<std::string> WebSocketClient::pollMessages() {
-  std::vector<std::string> out;
-  std::lock_guard<std::mutex> lock(queueMutex_);
-  out.reserve(inbound_.size());
-  while (!inbound_.empty()) {
-    out.push_back(std::move(inbound_.front()));
-    inbound_.pop_front();
+void WebSocketClient::setNetworkConditions(const NetworkConditions& conditions) {
+  websocketpp::lib::asio::post(client_.get_io_service(), [this, conditions]() { conditioner_.configure(conditions); });
+}
+
+void WebSocketClient::setRecorder(std::shared_ptr<SessionRecorder> recorder) {
+  websocketpp::lib::asio::post(client_.get_io_service(),
+                               [this, recorder = std::move(recorder)]() mutable { recorder_ = std::move(recorder); });
+}
+
+void WebSocketClient::queueDelayed(NetworkConditioner::Clock::time_point at, DelayedFrame frame) {
+  const bool newHead = delayed_.empty() || at < delayed_.begin()->first;
+  // Equal keys keep insertion order, so same-instant frames stay FIFO.
+  delayed_.emplace(at, std::move(frame));
+  if (newHead) {
+    armDelayTimer();
   }
-  return out;
+}
+
+void WebSocketClient::armDelayTimer() {
+  if (delayTimer_) {
+    delayTimer_->cancel();
+    delayTimer_.reset();
+  }
+  if (delayed_.empty()) {
+    return;
+  }
+  const auto wait = std::chrono::ceil<std::chrono::milliseconds>(delayed_.begin()->first -
+                                                                  NetworkConditioner::Clock::now());
+  delayTimer_ = client_.set_timer(std::max<long>(0, static_cast<long>(wait.count())),
+                                  [this](const websocketpp::lib::error_code& ec) {
+                                    if (!ec) {
+                                      releaseDelayed();
+                                    }
+                                  });
+}
+
+void WebSocketClient::releaseDelayed() {
+  const auto now = NetworkConditioner::Clock::now();
+  while (!delayed_.empty() && delayed_.begin()->first <= now) {
+    DelayedFrame frame = std::move(delayed_.begin()->second);
+    delayed_.erase(delayed_.begin());
+    if (frame.connectionId != connectionId_.load() || state_.load() != ConnectionState::Open) {
+      continue;
+    }
+    if (frame.control) {
+      if (frame.inbound) {
+        handlePong(frame.payload);
+      } else {
+        sendPing(frame.payload);
+      }
+    } else if (frame.inbound) {
+      pushInbound(frame.frame, frame.binary);
+    } else {
+      sendNow(frame.payload, frame.binary);
+    }
+  }
+  delayTimer_.reset();
+  armDelayTimer();
+}
+
+void WebSocketClient::scheduleForcedDisconnect(std::uint32_t connectionId) {
+  const long afterMs = static_cast<long>(conditioner_.conditions().disconnectEverySec) * 1000;
+  client_.set_timer(afterMs, [this, connectionId](const websocketpp::lib::error_code& ec) {
+    if (ec || state_.load() != ConnectionState::Open || connectionId != connectionId_.load()) {
+      return;
+    }
+    // Looks like a server-side drop to the rest of the client: reconnect/backoff kicks in.
+    websocketpp::lib::error_code closeEc;
+    client_.close(hdl_, websocketpp::close::status::going_away, "network conditioner", closeEc);
+  });
+}
+
+void WebSocketClient::pushInbound(const WorldMessagePtr& frame, bool binary) {
+  if (recorder_) {
+    recorder_->write(binary ? RecordKind::InboundBinary : RecordKind::InboundText, frame->get_payload());
+  }
+  const std::uint64_t receivedAtMs = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+  SpilledFrame entry{frame, binary, activeGeneration_, connectionId_.load(), receivedAtMs};
+  if (spill_.empty() && tryPushInbound(entry)) {
+    return;
+  }
+
+  // Ring is full: the render thread is behind. Keep the frame in order behind
+  // the ones already waiting; the io thread carries on with pings and sends.
+  spill_.push_back(std::move(entry));
+  spilledInbound_.fetch_add(1);
+  drainSpill();
+  if (spill_.size() > kInboundSpillLimit) {
+    spill_.clear();
+    spillDepth_.store(0);
+    closeActive(websocketpp::close::status::going_away, "inbound backlog");
+    handleDrop(autoReconnect_.load() ? "Inbound backlog overflow, reconnecting" : "Inbound backlog overflow");
+  }
+}
+
+bool WebSocketClient::tryPushInbound(const SpilledFrame& frame) {
+  const bool decode = decodeOnNetworkThread_.load(std::memory_order_relaxed);
+  const bool pushed = inbound_.tryPush([&frame, decode](InboundMessage& slot) {
+    slot.generation = frame.generation;
+    slot.connectionId = frame.connectionId;
+    slot.receivedAtMs = frame.receivedAtMs;
+    slot.frame = frame.frame;
+    slot.binary = frame.binary;
+    slot.isDecoded = decode;
+    slot.decodeNs = 0;
+    if (decode) {
+      const auto start = std::chrono::steady_clock::now();
+      decodeWorldMessage(slot.payload(), frame.binary, slot.decoded);
+      slot.decodeNs = static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+  });
+  if (!pushed) {
+    return false;
+  }
+  // Single producer, so a plain load/store keeps the high-water mark exact.
+  const std::size_t depth = inbound_.size();
+  if (depth > inboundHighWater_.load(std::memory_order_relaxed)) {
+    inboundHighWater_.store(depth, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+void WebSocketClient::drainSpill() {
+  while (!spill_.empty()) {
+    // Frames from before a connect()/disconnect() would be skipped by the consumer anyway.
+    if (spill_.front().generation == generation_.load() && !tryPushInbound(spill_.front())) {
+      break;
+    }
+    spill_.pop_front();
+  }
+  spillDepth_.store(spill_.size());
+  if (spill_.empty() || spillTimer_) {
+    return;
+  }
+  spillTimer_ = client_.set_timer(kSpillRetryMs, [this](const websocketpp::lib::error_code& ec) {
+    spillTimer_.reset();
+    if (!ec) {
+      drainSpill();
+    }
+  });
+}
+
+void WebSocketClient::setCompressionEnabled(bool enabled) {
+  hooks_.offerDeflate.store(enabled);
+}
+
+WebSocketClient::ByteStats WebSocketClient::byteStats() const {
+  const auto& counters = hooks_.counters;
+  ByteStats stats;
+  stats.wireIn = counters.wireIn.load();
+  stats.payloadIn = counters.payloadIn.load();
+  stats.wireOut = counters.wireOut.load();
+  stats.payloadOut = counters.payloadOut.load();
+  return stats;
 }
 
 void WebSocketClient::setStatus(const std::string& s) {
@@ -1,42 +1,267 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <deque>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include <websocketpp/client.hpp>
-#include <websocketpp/config/asio_no_tls_client.hpp>
+
+#include "Backoff.hpp"
+#include "NetworkConditioner.hpp"
+#include "SessionRecording.hpp"
+#include "SpscRing.hpp"
+#include "WebSocketConfig.hpp"
+#include "WorldEvents.hpp"
+
+using WorldMessagePtr = websocketpp::client<WorldClientConfig>::message_ptr;
+
+// One ring slot. `frame` is websocketpp's own message, so the payload is never
+// copied; dropping it on release returns the buffer to the connection's pool.
+// `decoded` is filled on the io thread when network-thread decoding is
+// enabled; otherwise the consumer decodes payload() itself. `generation`
+// identifies the connect() call the frame belongs to.
+struct InboundMessage {
+  std::uint32_t generation = 0;
+  std::uint32_t connectionId = 0;  // WebSocketClient::connectionId() of the socket it arrived on
+  WorldMessagePtr frame;
+  bool binary = false;
+  bool isDecoded = false;
+  std::uint64_t decodeNs = 0;      // time spent in decodeWorldMessage(), wherever it ran
+  std::uint64_t receivedAtMs = 0;  // steady clock, same base as WorldState::nowMs()
+  DecodedMessage decoded;
+
+  const std::string& payload() const { return frame->get_payload(); }
+};
+
+// A ping goes out every `intervalMs` while the socket is open. A pong not
+// back within `pongTimeoutMs` (capped at the interval) counts as a miss; any
+// pong or inbound message clears the count, and `maxMissed` consecutive
+// misses drop the connection as dead.
+struct HeartbeatOptions {
+  long intervalMs = 1000;
+  long pongTimeoutMs = 1000;
+  int maxMissed = 2;
+};
+
+// Lifecycle of the world socket. Transitions happen on the io thread only.
+enum class ConnectionState : std::uint8_t { Idle, Connecting, Open, Closing, Backoff };
 
 class WebSocketClient {
  public:
   WebSocketClient();
   ~WebSocketClient();
 
+  // Both return immediately; the work is posted to the persistent io thread.
+  // connect() supersedes any previous connection, including a pending retry.
   bool connect(const std::string& url, const std::string& jwt);
   void disconnect();
-  bool sendText(const std::string& payload);
 
-  std::vector<std::string> pollMessages();
-  bool isConnected() const { return connected_.load(); }
+  // When enabled, an unexpected close or failed handshake moves to Backoff
+  // and retries with jittered exponential delay.
+  void setAutoReconnect(bool enabled) { autoReconnect_.store(enabled); }
+  // Call once the server accepted the session so the next drop retries fast.
+  void resetReconnectBackoff();
+  // Queues a frame for the io thread. A non-empty `coalesceKey` lets a newer
+  // intent replace the previous one if it is still the last unsent message.
+  // Only use a key for idempotent intents (attack/interact on a target);
+  // relative inputs such as `move` would lose the replaced step.
+  bool send(const std::string& payload, bool binary, const std::string& coalesceKey = {});
+  bool sendText(const std::string& payload, const std::string& coalesceKey = {}) {
+    return send(payload, false, coalesceKey);
+  }
+
+  using InboundView = SpscRing<InboundMessage>::View;
+
+  // Consumer side (main thread only). The view points straight into the ring
+  // slots and must be handed back with releaseMessages() before the next call.
+  // Slots for which isCurrent() is false predate the last connect/disconnect,
+  // or arrived on a socket that has since dropped (a resume replays those).
+  InboundView acquireMessages() { return inbound_.acquire(); }
+  void releaseMessages(const InboundView& view) {
+    for (InboundMessage& msg : view) {
+      msg.frame.reset();
+    }
+    inbound_.release(view);
+  }
+  bool isCurrent(const InboundMessage& msg) const {
+    return msg.generation == generation_.load() && msg.connectionId >= firstLiveConnectionId_.load();
+  }
+
+  // Calls `fn` for every current message and releases the whole batch.
+  template <typename Fn>
+  std::size_t drainMessages(Fn&& fn) {
+    const InboundView view = inbound_.acquire();
+    std::size_t applied = 0;
+    for (InboundMessage& msg : view) {
+      if (isCurrent(msg)) {
+        fn(msg);
+        ++applied;
+      }
+    }
+    releaseMessages(view);
+    return applied;
+  }
+
+  // Takes effect from the next connection.
+  void setHeartbeat(const HeartbeatOptions& options);
+  // Connections dropped because heartbeats went unanswered.
+  std::uint64_t heartbeatTimeouts() const { return heartbeatTimeouts_.load(); }
+
+  // Debug link simulation applied to both directions on the io thread.
+  // Takes effect for messages sent or received after the call.
+  void setNetworkConditions(const NetworkConditions& conditions);
+  std::uint64_t conditionerDropped() const { return conditionerDropped_.load(); }
+
+  // Captures every inbound payload (as delivered to the ring) and every
+  // outbound one (as flushed) until replaced or the client is destroyed.
+  void setRecorder(std::shared_ptr<SessionRecorder> recorder);
+
+  // Runs decodeWorldMessage() on the io thread so the frame loop only applies events.
+  void setDecodeOnNetworkThread(bool enabled) { decodeOnNetworkThread_.store(enabled); }
+
+  // Offers permessage-deflate on the next connect. No-op when built without
+  // MMORP_WS_DEFLATE.
+  void setCompressionEnabled(bool enabled);
+  bool compressionActive() const { return compressionActive_.load(); }
+
+  struct ByteStats {
+    std::uint64_t wireIn = 0;
+    std::uint64_t payloadIn = 0;
+    std::uint64_t wireOut = 0;
+    std::uint64_t payloadOut = 0;
+  };
+  // Totals for the current connection; reset on connect().
+  ByteStats byteStats() const;
+
+  ConnectionState state() const { return state_.load(); }
+  // False as soon as connect()/disconnect() is called, before the io thread
+  // has acted on it.
+  bool isConnected() const {
+    return state_.load() == ConnectionState::Open && openGeneration_.load() == generation_.load();
+  }
+  bool isConnecting() const { return state_.load() == ConnectionState::Connecting; }
+  // Increments on every successful open, so callers can tell a reconnect
+  // happened even if they never observed the socket down.
+  std::uint32_t connectionId() const { return connectionId_.load(); }
   std::string lastStatus() const;
+  // Frames that found the ring full and waited in the overflow list.
+  std::uint64_t spilledInbound() const { return spilledInbound_.load(); }
+  std::size_t inboundDepth() const { return inbound_.size() + spillDepth_.load(); }
+  std::size_t inboundHighWater() const { return inboundHighWater_.load(); }
+  void resetInboundHighWater() { inboundHighWater_.store(0); }
+  // WebSocket ping/pong round trip in microseconds; -1 until the first pong.
+  std::int64_t rttUs() const { return rttUs_.load(); }
+  std::int64_t smoothedRttUs() const { return smoothedRttUs_.load(); }
+  std::uint64_t coalescedOutbound() const { return coalescedOutbound_.load(); }
 
  private:
-  using Client = websocketpp::client<websocketpp::config::asio_client>;
+  using Client = websocketpp::client<WorldClientConfig>;
+
+  static constexpr std::size_t kInboundCapacity = 4096;
+  // Past this many spilled frames the render thread is not catching up; the
+  // connection is dropped so the resume replays from the last applied seq.
+  static constexpr std::size_t kInboundSpillLimit = 65536;
+  static constexpr long kSpillRetryMs = 2;
+
+  // A received frame waiting for a ring slot.
+  struct SpilledFrame {
+    WorldMessagePtr frame;
+    bool binary = false;
+    std::uint32_t generation = 0;
+    std::uint32_t connectionId = 0;
+    std::uint64_t receivedAtMs = 0;
+  };
 
   void setStatus(const std::string& s);
+  void pushInbound(const WorldMessagePtr& frame, bool binary);
+  bool tryPushInbound(const SpilledFrame& frame);
+  void drainSpill();
+  void flushOutbound();
+
+  // io thread only.
+  bool isActive(websocketpp::connection_hdl hdl) const;
+  void openConnection();
+  void closeActive(websocketpp::close::status::value code, const std::string& reason);
+  bool finishClosing(websocketpp::connection_hdl hdl);
+  void handleDrop(const std::string& status);
+  void cancelReconnect();
+  void schedulePing(std::uint32_t connectionId);
+  void handlePongTimeout();
+  bool sendNow(const std::string& payload, bool binary);
+
+  // Messages held back by the conditioner, released by a single timer.
+  struct DelayedFrame {
+    std::string payload;  // outbound only
+    bool binary = false;
+    bool inbound = false;
+    std::uint32_t connectionId = 0;
+    WorldMessagePtr frame;  // inbound only
+    bool control = false;   // a ping (outbound) or pong (inbound); payload is the timestamp
+  };
+  void queueDelayed(NetworkConditioner::Clock::time_point at, DelayedFrame frame);
+  void armDelayTimer();
+  void releaseDelayed();
+  void scheduleForcedDisconnect(std::uint32_t connectionId);
+  void sendPing(const std::string& payload);
+  void handlePong(const std::string& payload);
+
+  struct OutboundMessage {
+    std::string payload;
+    bool binary = false;
+    std::string coalesceKey;
+  };
 
   Client client_;
-  websocketpp::connection_hdl hdl_;
   std::thread thread_;
 
-  std::atomic<bool> running_{false};
-  std::atomic<bool> connected_{false};
+  // io thread only.
+  websocketpp::connection_hdl hdl_;
+  websocketpp::connection_hdl closing_;
+  std::string url_;
+  std::string jwt_;
+  std::uint32_t activeGeneration_ = 0;
+  ExponentialBackoff backoff_;
+  Client::timer_ptr reconnectTimer_;
+  Client::timer_ptr pingTimer_;
+  HeartbeatOptions heartbeat_;
+  int missedPongs_ = 0;
+  NetworkConditioner conditioner_;
+  std::shared_ptr<SessionRecorder> recorder_;
+  std::multimap<NetworkConditioner::Clock::time_point, DelayedFrame> delayed_;
+  Client::timer_ptr delayTimer_;
+  std::deque<SpilledFrame> spill_;
+  Client::timer_ptr spillTimer_;
+
+  std::atomic<ConnectionState> state_{ConnectionState::Idle};
+  std::atomic<std::uint32_t> generation_{0};  // written by the main thread
+  std::atomic<std::uint32_t> openGeneration_{0};
+  std::atomic<std::uint32_t> connectionId_{0};
+  std::atomic<std::uint32_t> firstLiveConnectionId_{0};  // frames from older sockets are discarded
+  std::atomic<bool> autoReconnect_{false};
+  std::atomic<bool> compressionActive_{false};
+  WorldSocketHooks hooks_;  // bound to thread_, read by the deflate extension
   mutable std::mutex statusMutex_;
   std::string status_ = "Disconnected";
 
-  mutable std::mutex queueMutex_;
-  std::deque<std::string> inbound_;
+  SpscRing<InboundMessage> inbound_{kInboundCapacity};
+  std::atomic<bool> decodeOnNetworkThread_{false};
+  std::atomic<std::uint64_t> spilledInbound_{0};
+  std::atomic<std::size_t> spillDepth_{0};
+  std::atomic<std::uint64_t> conditionerDropped_{0};
+  std::atomic<std::size_t> inboundHighWater_{0};
+  std::atomic<std::int64_t> rttUs_{-1};
+  std::atomic<std::int64_t> smoothedRttUs_{-1};
+  std::atomic<std::uint64_t> heartbeatTimeouts_{0};
+
+  std::mutex outboundMutex_;
+  std::vector<OutboundMessage> outbound_;
+  std::vector<OutboundMessage> flushing_;  // io thread only
+  std::atomic<bool> flushScheduled_{false};
+  std::atomic<std::uint64_t> coalescedOutbound_{0};
 };
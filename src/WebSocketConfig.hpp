@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <websocketpp/config/asio_no_tls_client.hpp>
+#include <websocketpp/message_buffer/alloc.hpp>
+#include <websocketpp/message_buffer/message.hpp>
+
+#if MMORP_WS_DEFLATE
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
+#endif
+
+// Byte counters for the active world connection. "wire" is what crossed the
+// socket as frame payload (compressed where deflate applied), "payload" is
+// the application data after inflate / before deflate.
+struct WireByteCounters {
+  std::atomic<std::uint64_t> wireIn{0};
+  std::atomic<std::uint64_t> payloadIn{0};
+  std::atomic<std::uint64_t> wireOut{0};
+  std::atomic<std::uint64_t> payloadOut{0};
+
+  void reset() {
+    wireIn.store(0);
+    payloadIn.store(0);
+    wireOut.store(0);
+    payloadOut.store(0);
+  }
+};
+
+// State a WebSocketClient shares with the deflate extension of its own
+// connections. websocketpp constructs the extension with no handle on its
+// connection, but every call into it (offer, compress, decompress) runs on
+// the io thread of the owning client, which binds its hooks there on start.
+struct WorldSocketHooks {
+  WireByteCounters counters;
+  std::atomic<bool> offerDeflate{true};
+};
+
+inline WorldSocketHooks*& boundSocketHooks() {
+  thread_local WorldSocketHooks* hooks = nullptr;
+  return hooks;
+}
+
+// Per-connection message manager that hands out recycled message objects
+// instead of allocating one (plus a payload buffer) per frame. A pooled
+// message is free again once the pool holds the only reference, i.e. after
+// websocketpp is done with it and the consumer has released its ring slot.
+// websocketpp calls get_message() from the io thread only for our client.
+template <typename message>
+class PooledMessageManager : public std::enable_shared_from_this<PooledMessageManager<message>> {
+ public:
+  typedef PooledMessageManager<message> type;
+  typedef std::shared_ptr<PooledMessageManager> ptr;
+  typedef std::weak_ptr<PooledMessageManager> weak_ptr;
+  typedef typename message::ptr message_ptr;
+
+  message_ptr get_message() { return std::make_shared<message>(this->shared_from_this()); }
+
+  message_ptr get_message(websocketpp::frame::opcode::value op, std::size_t size) {
+    const std::size_t probes = std::min(kProbes, pool_.size());
+    for (std::size_t i = 0; i < probes; ++i) {
+      message_ptr& candidate = pool_[cursor_];
+      cursor_ = (cursor_ + 1) % pool_.size();
+      if (candidate.use_count() == 1) {
+        // Pairs with the release in the last other owner's shared_ptr reset.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        reuse(*candidate, op, size);
+        return candidate;
+      }
+    }
+    message_ptr fresh = std::make_shared<message>(this->shared_from_this(), op, size);
+    if (pool_.size() < kMaxPooled) {
+      pool_.push_back(fresh);
+    }
+    return fresh;
+  }
+
+  bool recycle(message*) { return false; }
+
+ private:
+  // Releases are roughly FIFO, so the slot after the last hit is usually free.
+  static constexpr std::size_t kProbes = 8;
+  static constexpr std::size_t kMaxPooled = 1024;
+  static constexpr std::size_t kMaxRetainedBytes = 64 * 1024;
+
+  static void reuse(message& msg, websocketpp::frame::opcode::value op, std::size_t size) {
+    std::string& payload = msg.get_raw_payload();
+    if (payload.capacity() > kMaxRetainedBytes && size <= kMaxRetainedBytes) {
+      std::string().swap(payload);  // don't pin a one-off welcome-sized buffer
+    }
+    payload.clear();
+    payload.reserve(size);
+    msg.set_opcode(op);
+    msg.set_header(std::string());
+    msg.set_prepared(false);
+    msg.set_fin(true);
+    msg.set_terminal(false);
+    msg.set_compressed(false);
+  }
+
+  std::vector<message_ptr> pool_;
+  std::size_t cursor_ = 0;
+};
+
+#if MMORP_WS_DEFLATE
+// permessage-deflate whose offer can be switched off at runtime (websocketpp
+// only picks extensions at compile time) and which reports compressed sizes.
+// The processor calls these members on the concrete type, so hiding is enough.
+template <typename config>
+class CountingDeflate : public websocketpp::extensions::permessage_deflate::enabled<config> {
+ public:
+  using base = websocketpp::extensions::permessage_deflate::enabled<config>;
+
+  std::string generate_offer() const {
+    const WorldSocketHooks* hooks = boundSocketHooks();
+    return !hooks || hooks->offerDeflate.load() ? base::generate_offer() : std::string();
+  }
+
+  websocketpp::lib::error_code compress(std::string const& in, std::string& out) {
+    const std::size_t before = out.size();
+    const auto ec = base::compress(in, out);
+    if (WorldSocketHooks* hooks = boundSocketHooks()) {
+      hooks->counters.wireOut.fetch_add(out.size() - before);
+    }
+    return ec;
+  }
+
+  websocketpp::lib::error_code decompress(uint8_t const* buf, size_t len, std::string& out) {
+    if (WorldSocketHooks* hooks = boundSocketHooks()) {
+      hooks->counters.wireIn.fetch_add(len);
+    }
+    return base::decompress(buf, len, out);
+  }
+};
+#endif
+
+struct WorldClientConfig : public websocketpp::config::asio_client {
+  typedef WorldClientConfig type;
+  typedef websocketpp::config::asio_client base;
+
+  typedef base::concurrency_type concurrency_type;
+  typedef base::request_type request_type;
+  typedef base::response_type response_type;
+  typedef websocketpp::message_buffer::message<PooledMessageManager> message_type;
+  typedef PooledMessageManager<message_type> con_msg_manager_type;
+  typedef websocketpp::message_buffer::alloc::endpoint_msg_manager<con_msg_manager_type> endpoint_msg_manager_type;
+  typedef base::alog_type alog_type;
+  typedef base::elog_type elog_type;
+  typedef base::rng_type rng_type;
+  typedef base::transport_type transport_type;
+
+#if MMORP_WS_DEFLATE
+  typedef CountingDeflate<base::permessage_deflate_config> permessage_deflate_type;
+#endif
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "WorldState.hpp"
+
+// Encodings a world frame can use. Binary ones are negotiated in `join`.
+enum class WireEncoding : std::uint8_t { Json, MsgPack, Cbor };
+
+// Typed form of one inbound world message. Produced by decodeWorldMessage()
+// (possibly on the network thread) and applied to WorldState on the main thread.
+
+struct WorldError {
+  std::string text;
+};
+
+struct ChatNotice {
+  std::string text;
+};
+
+struct TileMap {
+  int width = 0;
+  int height = 0;
+  std::vector<TileType> tiles;
+};
+
+struct Welcome {
+  std::optional<std::string> selfId;
+  std::optional<TileMap> map;
+  std::optional<std::vector<PlayerState>> players;
+  std::optional<std::vector<NpcState>> npcs;
+  std::optional<std::vector<MobState>> mobs;
+  std::optional<int> selfX;
+  std::optional<int> selfY;
+  std::optional<WireEncoding> encoding;
+};
+
+// Reply to a join carrying `last_seq`: the server will replay missed
+// messages instead of sending a fresh welcome.
+struct Resumed {
+  std::uint64_t fromSeq = 0;
+  std::optional<WireEncoding> encoding;  // absent: the one agreed in welcome still applies
+};
+
+// The server filters by the announced interest area from now on. Without
+// x/y/w/h it accepted the last `interest` the client sent.
+struct InterestAck {
+  bool hasArea = false;
+  int x = 0;
+  int y = 0;
+  int w = 0;
+  int h = 0;
+};
+
+// Entities the server stopped updating because they left the acknowledged
+// interest area (or the area moved away from them).
+struct InterestLeave {
+  std::vector<std::string> players;
+  std::vector<std::string> mobs;
+};
+
+struct PlayerUpsert {
+  PlayerState player;
+  bool joined = false;
+  std::uint32_t ackInputSeq = 0;  // last local `move` input_seq the server applied, 0 if not sent
+};
+
+// Bits of EntityDelta::mask. A set bit means the field is present and changed.
+namespace DeltaField {
+constexpr std::uint32_t kX = 1u << 0;
+constexpr std::uint32_t kY = 1u << 1;
+constexpr std::uint32_t kHp = 1u << 2;
+constexpr std::uint32_t kMaxHp = 1u << 3;
+constexpr std::uint32_t kAlive = 1u << 4;
+constexpr std::uint32_t kLevel = 1u << 5;
+constexpr std::uint32_t kExperience = 1u << 6;
+constexpr std::uint32_t kName = 1u << 7;
+constexpr std::uint32_t kClass = 1u << 8;
+constexpr std::uint32_t kAggressive = 1u << 9;
+constexpr std::uint32_t kPosition = kX | kY;
+}  // namespace DeltaField
+
+// Changed fields of one player or mob. Only members named by `mask` are valid.
+struct EntityDelta {
+  std::string id;
+  std::uint32_t mask = 0;
+  int x = 0;
+  int y = 0;
+  int hp = 0;
+  int maxHp = 0;
+  bool alive = true;
+  int level = 0;
+  int experience = 0;
+  bool aggressive = false;
+  std::string name;
+  std::string className;
+};
+
+// `world_delta`: changes relative to the state after message `baselineSeq`.
+struct WorldDelta {
+  std::uint64_t baselineSeq = 0;
+  std::uint32_t ackInputSeq = 0;
+  std::vector<EntityDelta> players;
+  std::vector<EntityDelta> mobs;
+  std::vector<std::string> removedPlayers;
+  std::vector<std::string> removedMobs;
+};
+
+struct PlayerLeft {
+  std::string id;
+};
+
+struct MobUpsert {
+  std::vector<MobState> mobs;
+};
+
+struct Combat {
+  std::string targetId;
+  int damage = 0;
+};
+
+struct PlayerDied {
+  std::string id;
+};
+
+struct DialogStart {
+  DialogState dialog;
+  std::string questTrigger;
+};
+
+struct DialogEnd {
+  std::string npcId;
+  std::string npcName;
+  std::string questTrigger;
+};
+
+struct NpcResponse {
+  std::string npcId;
+  std::string text;
+  std::vector<std::string> options;
+};
+
+using WorldEvent = std::variant<std::monostate, WorldError, ChatNotice, Welcome, Resumed, InterestAck, InterestLeave,
+                                PlayerUpsert, WorldDelta, PlayerLeft, MobUpsert, Combat, PlayerDied, DialogStart,
+                                DialogEnd, NpcResponse>;
+
+struct DecodedMessage {
+  std::string type;
+  std::uint64_t seq = 0;          // server sequence number, 0 when absent
+  std::int64_t serverTimeMs = 0;  // server clock (`server_time`/`ts`), 0 when absent
+  WorldEvent event;
+};
@@ -0,0 +1,987 @@
+#include "WorldProtocol.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+std::optional<std::string> getStringField(const json& j, std::initializer_list<const char*> keys) {
+  for (const char* key : keys) {
+    if (j.contains(key) && j[key].is_string()) {
+      return j[key].get<std::string>();
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<int> getIntField(const json& j, std::initializer_list<const char*> keys) {
+  for (const char* key : keys) {
+    if (!j.contains(key)) {
+      continue;
+    }
+    const auto& v = j[key];
+    if (v.is_number_integer()) {
+      return v.get<int>();
+    }
+    if (v.is_number_float()) {
+      return static_cast<int>(std::round(v.get<float>()));
+    }
+    if (v.is_string()) {
+      try {
+        return std::stoi(v.get<std::string>());
+      } catch (...) {
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+namespace {
+// Server clock in milliseconds, 0 when the message carries none.
+std::int64_t parseServerTime(const json& msg) {
+  for (const char* key : {"server_time", "serverTime", "ts", "timestamp"}) {
+    const auto it = msg.find(key);
+    if (it == msg.end() || !it->is_number()) {
+      continue;
+    }
+    return it->is_number_float() ? static_cast<std::int64_t>(it->get<double>()) : it->get<std::int64_t>();
+  }
+  return 0;
+}
+
+std::pair<int, int> parsePosition2D(const json& j) {
+  if (j.contains("position") && j["position"].is_object()) {
+    const auto& p = j["position"];
+    const int x = getIntField(p, {"x", "tileX", "col"}).value_or(0);
+    const int y = getIntField(p, {"y", "tileY", "row"}).value_or(0);
+    return {x, y};
+  }
+  const int x = getIntField(j, {"x", "tileX", "col"}).value_or(0);
+  const int y = getIntField(j, {"y", "tileY", "row"}).value_or(0);
+  return {x, y};
+}
+
+TileType parseTileName(std::string s) {
+  std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  if (s == "water" || s == "w") {
+    return TileType::Water;
+  }
+  if (s == "wall" || s == "#") {
+    return TileType::Wall;
+  }
+  if (s == "forest" || s == "f") {
+    return TileType::Forest;
+  }
+  return TileType::Grass;
+}
+
+// One character of a string row; same mapping as the one-letter names.
+TileType parseTileChar(char c) {
+  switch (std::tolower(static_cast<unsigned char>(c))) {
+    case 'w':
+      return TileType::Water;
+    case '#':
+      return TileType::Wall;
+    case 'f':
+      return TileType::Forest;
+    default:
+      return TileType::Grass;
+  }
+}
+
+TileType parseTileType(const json& node) {
+  if (node.is_string()) {
+    return parseTileName(node.get<std::string>());
+  }
+  if (node.is_number_integer()) {
+    switch (node.get<int>()) {
+      case 1:
+        return TileType::Water;
+      case 2:
+        return TileType::Wall;
+      case 3:
+        return TileType::Forest;
+      default:
+        return TileType::Grass;
+    }
+  }
+  return TileType::Grass;
+}
+
+PlayerState parsePlayer(const json& j) {
+  PlayerState p;
+  p.id = getStringField(j, {"id", "playerId", "userId", "username", "name"}).value_or("");
+  p.name = getStringField(j, {"name", "username", "displayName"}).value_or(p.id);
+  p.className = getStringField(j, {"class", "character", "job"}).value_or("Unknown");
+  p.level = getIntField(j, {"level"}).value_or(1);
+  p.experience = getIntField(j, {"experience", "xp"}).value_or(0);
+  p.hp = getIntField(j, {"hp", "health"}).value_or(100);
+  p.maxHp = std::max(1, getIntField(j, {"maxHP", "maxHp", "hpMax", "maxHealth"}).value_or(100));
+  p.alive = p.hp > 0;
+  const auto [x, y] = parsePosition2D(j);
+  p.x = x;
+  p.y = y;
+  p.renderX = static_cast<float>(x);
+  p.renderY = static_cast<float>(y);
+  return p;
+}
+
+NpcState parseNpc(const json& j) {
+  NpcState n;
+  n.id = getStringField(j, {"id", "npcId", "name"}).value_or("");
+  n.name = getStringField(j, {"name"}).value_or(n.id);
+  n.role = getStringField(j, {"role", "npc_role"}).value_or("");
+  n.portrait = getStringField(j, {"portrait", "npc_portrait"}).value_or("");
+  const auto [x, y] = parsePosition2D(j);
+  n.x = x;
+  n.y = y;
+  n.renderX = static_cast<float>(x);
+  n.renderY = static_cast<float>(y);
+  return n;
+}
+
+std::vector<DialogResponseState> parseDialogResponses(const json& node) {
+  std::vector<DialogResponseState> responses;
+  if (!node.contains("responses") || !node["responses"].is_array()) {
+    return responses;
+  }
+  responses.reserve(node["responses"].size());
+  for (const auto& entry : node["responses"]) {
+    if (!entry.is_object()) {
+      continue;
+    }
+    DialogResponseState resp;
+    resp.id = getStringField(entry, {"id"}).value_or("");
+    resp.text = getStringField(entry, {"text", "label", "name"}).value_or("");
+    resp.nextNodeId = getStringField(entry, {"next_node_id", "nextNodeId"}).value_or("");
+    resp.questTrigger = getStringField(entry, {"quest_trigger", "questTrigger"}).value_or("");
+    if (!resp.id.empty() && !resp.text.empty()) {
+      responses.push_back(resp);
+    }
+  }
+  return responses;
+}
+
+MobState parseMob(const json& j) {
+  MobState m;
+  m.id = getStringField(j, {"id", "mobId", "name"}).value_or("");
+  m.name = getStringField(j, {"name", "type"}).value_or(m.id);
+  m.hp = getIntField(j, {"hp", "health"}).value_or(100);
+  m.maxHp = std::max(1, getIntField(j, {"maxHP", "maxHp", "hpMax", "maxHealth"}).value_or(100));
+  m.alive = m.hp > 0;
+  m.aggressive = j.value("aggressive", j.value("isAggro", false));
+  const auto [x, y] = parsePosition2D(j);
+  m.x = x;
+  m.y = y;
+  m.renderX = static_cast<float>(x);
+  m.renderY = static_cast<float>(y);
+  return m;
+}
+
+// Deltas use one fixed key per field and read only what the mask names, so a
+// position-only change costs two integer lookups and no string copies.
+std::uint32_t inferDeltaMask(const json& j) {
+  std::uint32_t mask = 0;
+  const std::pair<const char*, std::uint32_t> keys[] = {
+      {"x", DeltaField::kX},       {"y", DeltaField::kY},
+      {"hp", DeltaField::kHp},     {"max_hp", DeltaField::kMaxHp},
+      {"alive", DeltaField::kAlive}, {"level", DeltaField::kLevel},
+      {"xp", DeltaField::kExperience}, {"name", DeltaField::kName},
+      {"class", DeltaField::kClass}, {"aggressive", DeltaField::kAggressive},
+  };
+  for (const auto& [key, bit] : keys) {
+    if (j.contains(key)) {
+      mask |= bit;
+    }
+  }
+  return mask;
+}
+
+bool parseEntityDelta(const json& j, EntityDelta& d) {
+  if (!j.is_object()) {
+    return false;
+  }
+  const auto id = j.find("id");
+  if (id == j.end() || !id->is_string()) {
+    return false;
+  }
+  d.id = id->get<std::string>();
+  const auto mask = j.find("m");
+  d.mask = (mask != j.end() && mask->is_number_unsigned()) ? mask->get<std::uint32_t>() : inferDeltaMask(j);
+
+  const auto readInt = [&j, &d](std::uint32_t bit, const char* key, int& out) {
+    if ((d.mask & bit) == 0) {
+      return;
+    }
+    const auto it = j.find(key);
+    if (it != j.end() && it->is_number()) {
+      out = it->get<int>();
+    }
+  };
+  readInt(DeltaField::kX, "x", d.x);
+  readInt(DeltaField::kY, "y", d.y);
+  readInt(DeltaField::kHp, "hp", d.hp);
+  readInt(DeltaField::kMaxHp, "max_hp", d.maxHp);
+  readInt(DeltaField::kLevel, "level", d.level);
+  readInt(DeltaField::kExperience, "xp", d.experience);
+  if (d.mask & DeltaField::kAlive) {
+    d.alive = j.value("alive", true);
+  }
+  if (d.mask & DeltaField::kAggressive) {
+    d.aggressive = j.value("aggressive", false);
+  }
+  if (d.mask & DeltaField::kName) {
+    d.name = j.value("name", d.id);
+  }
+  if (d.mask & DeltaField::kClass) {
+    d.className = j.value("class", "Unknown");
+  }
+  return true;
+}
+
+void parseEntityDeltas(const json& msg, const char* key, std::vector<EntityDelta>& out) {
+  const auto it = msg.find(key);
+  if (it == msg.end() || !it->is_array()) {
+    return;
+  }
+  out.reserve(it->size());
+  for (const auto& node : *it) {
+    EntityDelta d;
+    if (parseEntityDelta(node, d)) {
+      out.push_back(std::move(d));
+    }
+  }
+}
+
+void parseIdList(const json& msg, const char* key, std::vector<std::string>& out) {
+  const auto it = msg.find(key);
+  if (it == msg.end() || !it->is_array()) {
+    return;
+  }
+  for (const auto& node : *it) {
+    if (node.is_string()) {
+      out.push_back(node.get<std::string>());
+    }
+  }
+}
+
+// An all-grass map sized by `dims` (width/w, height/h); nullopt for a bad size.
+std::optional<TileMap> allocateTileMap(const json& dims) {
+  const WorldSnapshot defaults;
+  TileMap map;
+  map.width = getIntField(dims, {"width", "w"}).value_or(defaults.width);
+  map.height = getIntField(dims, {"height", "h"}).value_or(defaults.height);
+  if (map.width <= 0 || map.height <= 0) {
+    return std::nullopt;
+  }
+  map.tiles.assign(static_cast<std::size_t>(map.width * map.height), TileType::Grass);
+  return map;
+}
+
+std::optional<TileMap> parseTileMap(const json& mapNode) {
+  std::optional<TileMap> map = allocateTileMap(mapNode);
+  if (!map || !mapNode.contains("tiles") || !mapNode["tiles"].is_array()) {
+    return map;
+  }
+  const int width = map->width;
+  const int height = map->height;
+  const auto& rows = mapNode["tiles"];
+  for (int y = 0; y < std::min(height, static_cast<int>(rows.size())); ++y) {
+    const auto& row = rows[static_cast<std::size_t>(y)];
+    if (row.is_string()) {
+      const std::string& s = row.get_ref<const std::string&>();
+      for (int x = 0; x < std::min(width, static_cast<int>(s.size())); ++x) {
+        map->tiles[static_cast<std::size_t>(y * width + x)] = parseTileChar(s[static_cast<std::size_t>(x)]);
+      }
+      continue;
+    }
+    if (!row.is_array()) {
+      continue;
+    }
+    for (int x = 0; x < std::min(width, static_cast<int>(row.size())); ++x) {
+      map->tiles[static_cast<std::size_t>(y * width + x)] = parseTileType(row[static_cast<std::size_t>(x)]);
+    }
+  }
+  return map;
+}
+
+template <typename T, typename Parse>
+std::vector<T> parseEntityList(const json& array, Parse parse) {
+  std::vector<T> out;
+  out.reserve(array.size());
+  for (const auto& node : array) {
+    T entity = parse(node);
+    if (!entity.id.empty()) {
+      out.push_back(std::move(entity));
+    }
+  }
+  return out;
+}
+
+// Later keys win, matching the order the welcome branch used to apply them:
+// world.* first, then top-level overrides.
+void decodeWelcomeSection(const json& node, Welcome& welcome) {
+  if (node.contains("map") && node["map"].is_object()) {
+    welcome.map = parseTileMap(node["map"]);
+  }
+  if (node.contains("players") && node["players"].is_array()) {
+    welcome.players = parseEntityList<PlayerState>(node["players"], parsePlayer);
+  }
+  if (node.contains("npcs") && node["npcs"].is_array()) {
+    welcome.npcs = parseEntityList<NpcState>(node["npcs"], parseNpc);
+  }
+  if (node.contains("mobs") && node["mobs"].is_array()) {
+    welcome.mobs = parseEntityList<MobState>(node["mobs"], parseMob);
+  }
+}
+
+Welcome decodeWelcome(const json& msg) {
+  Welcome welcome;
+  welcome.selfId = getStringField(msg, {"selfId", "playerId", "id"});
+
+  if (msg.contains("world") && msg["world"].is_object()) {
+    const auto& w = msg["world"];
+    if (!(w.contains("map") && w["map"].is_object()) && w.contains("tiles")) {
+      welcome.map = parseTileMap(w);
+    }
+    decodeWelcomeSection(w, welcome);
+  }
+  decodeWelcomeSection(msg, welcome);
+
+  if (msg.contains("character") && msg["character"].is_object()) {
+    const auto& charObj = msg["character"];
+    welcome.selfX = getIntField(charObj, {"pos_x", "x"});
+    welcome.selfY = getIntField(charObj, {"pos_y", "y"});
+  }
+  if (const auto encoding = getStringField(msg, {"encoding"}); encoding.has_value()) {
+    welcome.encoding = parseWireEncoding(*encoding);
+  }
+  return welcome;
+}
+
+// Builds the DOM for one small subtree (an entity, `character`) from SAX
+// events, the way the full parser would.
+class SubtreeBuilder {
+ public:
+  bool done() const { return stack_.empty(); }
+  void key(std::string k) { key_ = std::move(k); }
+  void value(json v) { slot() = std::move(v); }
+  void open(json container) {
+    json& target = slot();
+    target = std::move(container);
+    stack_.push_back(&target);
+  }
+  void close() { stack_.pop_back(); }
+  json take() { return std::move(root_); }
+
+ private:
+  // Where the next value goes. Pointers into a parent stay valid because
+  // the parent only grows again after the child on top of it has closed.
+  json& slot() {
+    if (stack_.empty()) {
+      return root_;
+    }
+    json& parent = *stack_.back();
+    if (parent.is_array()) {
+      parent.push_back(json());
+      return parent.back();
+    }
+    return parent[key_];
+  }
+
+  json root_;
+  std::vector<json*> stack_;
+  std::string key_;
+};
+
+// Streaming decoder for large `welcome` frames (nlohmann SAX interface).
+// Tiles go straight into one byte per tile and each entity is built from a
+// DOM of just that entity, so the whole-message DOM (tens of bytes per tile,
+// plus every entity at once) never exists. Scalars at the top level and under
+// `world` are kept as small objects so the schema-tolerant lookups above
+// still apply. Mirrors decodeWelcome(), including `world.*` being overridden
+// by top-level keys.
+class WelcomeSaxDecoder {
+ public:
+  using number_integer_t = json::number_integer_t;
+  using number_unsigned_t = json::number_unsigned_t;
+  using number_float_t = json::number_float_t;
+  using string_t = json::string_t;
+  using binary_t = json::binary_t;
+
+  bool null() { return onValue(Value::Scalar, json()); }
+  bool boolean(bool v) { return onValue(Value::Scalar, json(v)); }
+  bool number_integer(number_integer_t v) { return onValue(Value::Scalar, json(v)); }
+  bool number_unsigned(number_unsigned_t v) { return onValue(Value::Scalar, json(v)); }
+  bool number_float(number_float_t v, const string_t&) { return onValue(Value::Scalar, json(v)); }
+  bool binary(binary_t&) { return onValue(Value::Scalar, json()); }
+  bool string(string_t& v) {
+    if (!stack_.empty() && stack_.back().ctx == Ctx::Tiles) {
+      Row& row = stack_.back().rows->emplace_back();
+      row.reserve(v.size());
+      for (const char c : v) {
+        row.push_back(parseTileChar(c));
+      }
+      return true;
+    }
+    if (!stack_.empty() && stack_.back().ctx == Ctx::TileRow) {
+      stack_.back().rows->back().push_back(parseTileName(v));
+      return true;
+    }
+    return onValue(Value::Scalar, json(std::move(v)));
+  }
+  bool start_object(std::size_t) { return onValue(Value::Object, json()); }
+  bool start_array(std::size_t) { return onValue(Value::Array, json()); }
+  bool key(string_t& k) {
+    if (!stack_.empty() && stack_.back().ctx == Ctx::Capture) {
+      capture_.key(std::move(k));
+    } else {
+      key_ = std::move(k);
+    }
+    return true;
+  }
+  bool end_object() { return close(); }
+  bool end_array() { return close(); }
+  bool parse_error(std::size_t, const std::string&, const json::exception&) { return false; }
+
+  // False when the message is not a welcome; the caller then decodes it as a DOM.
+  bool finish(DecodedMessage& out) {
+    if (!stack_.empty() || !rootScalars_.is_object() || rootScalars_.value("type", "") != "welcome") {
+      return false;
+    }
+    out.type = "welcome";
+    if (rootScalars_.contains("seq") && rootScalars_["seq"].is_number_unsigned()) {
+      out.seq = rootScalars_["seq"].get<std::uint64_t>();
+    }
+    out.serverTimeMs = parseServerTime(rootScalars_);
+
+    Welcome welcome;
+    welcome.selfId = getStringField(rootScalars_, {"selfId", "playerId", "id"});
+    if (maps_[kWorld].present) {
+      welcome.map = assembleTileMap(maps_[kWorld].dims, maps_[kWorld].rows);
+    } else if (worldTiles_.present) {
+      welcome.map = assembleTileMap(worldScalars_, worldTiles_.rows);
+    }
+    takeEntities(sections_[kWorld], welcome);
+    if (maps_[kRoot].present) {
+      welcome.map = assembleTileMap(maps_[kRoot].dims, maps_[kRoot].rows);
+    }
+    takeEntities(sections_[kRoot], welcome);
+    if (character_.is_object()) {
+      welcome.selfX = getIntField(character_, {"pos_x", "x"});
+      welcome.selfY = getIntField(character_, {"pos_y", "y"});
+    }
+    if (const auto encoding = getStringField(rootScalars_, {"encoding"}); encoding.has_value()) {
+      welcome.encoding = parseWireEncoding(*encoding);
+    }
+    out.event = std::move(welcome);
+    return true;
+  }
+
+ private:
+  using Row = std::vector<TileType>;
+  enum class Value : std::uint8_t { Scalar, Object, Array };
+  enum class Ctx : std::uint8_t { Root, World, Map, Tiles, TileRow, Entities, Capture, Skip };
+  enum class Target : std::uint8_t { Player, Npc, Mob, Character };
+  enum Section : std::uint8_t { kRoot = 0, kWorld = 1 };
+
+  struct Frame {
+    Ctx ctx = Ctx::Skip;
+    Section section = kRoot;
+    Target target = Target::Player;  // Entities only
+    std::vector<Row>* rows = nullptr;  // Tiles and TileRow only
+  };
+
+  struct MapPart {
+    bool present = false;
+    json dims = json::object();
+    std::vector<Row> rows;
+  };
+
+  static TileMap assembleTileMapRows(TileMap map, const std::vector<Row>& rows) {
+    for (int y = 0; y < std::min(map.height, static_cast<int>(rows.size())); ++y) {
+      const Row& row = rows[static_cast<std::size_t>(y)];
+      const int n = std::min(map.width, static_cast<int>(row.size()));
+      std::copy(row.begin(), row.begin() + n, map.tiles.begin() + static_cast<std::ptrdiff_t>(y) * map.width);
+    }
+    return map;
+  }
+
+  static std::optional<TileMap> assembleTileMap(const json& dims, const std::vector<Row>& rows) {
+    std::optional<TileMap> map = allocateTileMap(dims);
+    if (!map) {
+      return std::nullopt;
+    }
+    return assembleTileMapRows(std::move(*map), rows);
+  }
+
+  static void takeEntities(Welcome& from, Welcome& into) {
+    if (from.players) {
+      into.players = std::move(from.players);
+    }
+    if (from.npcs) {
+      into.npcs = std::move(from.npcs);
+    }
+    if (from.mobs) {
+      into.mobs = std::move(from.mobs);
+    }
+  }
+
+  void push(Ctx ctx, Section section = kRoot, std::vector<Row>* rows = nullptr) {
+    Frame frame;
+    frame.ctx = ctx;
+    frame.section = section;
+    frame.rows = rows;
+    stack_.push_back(frame);
+  }
+
+  // Feeds one value to the capture in progress; finishes it if that was the last.
+  void captureValue(Value v, json scalar) {
+    if (v == Value::Scalar) {
+      capture_.value(std::move(scalar));
+      if (capture_.done()) {
+        finishCapture();
+      }
+      return;
+    }
+    capture_.open(v == Value::Object ? json::object() : json::array());
+    push(Ctx::Capture);
+  }
+
+  void finishCapture() {
+    json node = capture_.take();
+    Welcome& part = sections_[captureSection_];
+    switch (captureTarget_) {
+      case Target::Character:
+        character_ = std::move(node);
+        break;
+      case Target::Player:
+        if (PlayerState p = parsePlayer(node); !p.id.empty()) {
+          part.players->push_back(std::move(p));
+        }
+        break;
+      case Target::Npc:
+        if (NpcState n = parseNpc(node); !n.id.empty()) {
+          part.npcs->push_back(std::move(n));
+        }
+        break;
+      case Target::Mob:
+        if (MobState m = parseMob(node); !m.id.empty()) {
+          part.mobs->push_back(std::move(m));
+        }
+        break;
+    }
+  }
+
+  bool onValue(Value v, json scalar) {
+    if (stack_.empty()) {
+      if (v != Value::Object || started_) {
+        return false;
+      }
+      started_ = true;
+      push(Ctx::Root);
+      return true;
+    }
+    const Frame top = stack_.back();
+    switch (top.ctx) {
+      case Ctx::Root:
+      case Ctx::World:
+        onSectionValue(top.section, v, std::move(scalar));
+        return true;
+      case Ctx::Map:
+        if (v == Value::Array && key_ == "tiles") {
+          maps_[top.section].rows.clear();
+          push(Ctx::Tiles, top.section, &maps_[top.section].rows);
+        } else if (v == Value::Scalar) {
+          maps_[top.section].dims[key_] = std::move(scalar);
+        } else {
+          push(Ctx::Skip);
+        }
+        return true;
+      case Ctx::Tiles:
+        // Rows that are neither strings nor arrays still take up a row index.
+        top.rows->emplace_back();
+        if (v == Value::Array) {
+          push(Ctx::TileRow, top.section, top.rows);
+        } else if (v == Value::Object) {
+          push(Ctx::Skip);
+        }
+        return true;
+      case Ctx::TileRow:
+        top.rows->back().push_back(v == Value::Scalar ? parseTileType(scalar) : TileType::Grass);
+        if (v != Value::Scalar) {
+          push(Ctx::Skip);
+        }
+        return true;
+      case Ctx::Entities:
+        captureTarget_ = top.target;
+        captureSection_ = top.section;
+        captureValue(v, std::move(scalar));
+        return true;
+      case Ctx::Capture:
+        captureValue(v, std::move(scalar));
+        return true;
+      case Ctx::Skip:
+        if (v != Value::Scalar) {
+          push(Ctx::Skip);
+        }
+        return true;
+    }
+    return false;
+  }
+
+  void onSectionValue(Section section, Value v, json scalar) {
+    Welcome& part = sections_[section];
+    if (v == Value::Array && (key_ == "players" || key_ == "npcs" || key_ == "mobs")) {
+      Frame frame;
+      frame.ctx = Ctx::Entities;
+      frame.section = section;
+      if (key_ == "players") {
+        part.players.emplace();
+        frame.target = Target::Player;
+      } else if (key_ == "npcs") {
+        part.npcs.emplace();
+        frame.target = Target::Npc;
+      } else {
+        part.mobs.emplace();
+        frame.target = Target::Mob;
+      }
+      stack_.push_back(frame);
+      return;
+    }
+    if (v == Value::Object && key_ == "map") {
+      maps_[section] = MapPart{};
+      maps_[section].present = true;
+      push(Ctx::Map, section);
+      return;
+    }
+    if (section == kRoot && v == Value::Object && key_ == "world") {
+      push(Ctx::World, kWorld);
+      return;
+    }
+    if (section == kRoot && v == Value::Object && key_ == "character") {
+      captureTarget_ = Target::Character;
+      captureValue(v, json());
+      return;
+    }
+    if (section == kWorld && key_ == "tiles") {
+      // Map fields directly under `world`; used only when there is no world.map.
+      worldTiles_.present = true;
+      worldTiles_.rows.clear();
+      if (v == Value::Array) {
+        push(Ctx::Tiles, kWorld, &worldTiles_.rows);
+        return;
+      }
+    }
+    if (v == Value::Scalar) {
+      (section == kRoot ? rootScalars_ : worldScalars_)[key_] = std::move(scalar);
+      return;
+    }
+    push(Ctx::Skip);
+  }
+
+  bool close() {
+    if (stack_.empty()) {
+      return false;
+    }
+    const Ctx ctx = stack_.back().ctx;
+    stack_.pop_back();
+    if (ctx == Ctx::Capture) {
+      capture_.close();
+      if (capture_.done()) {
+        finishCapture();
+      }
+    }
+    return true;
+  }
+
+  std::vector<Frame> stack_;
+  std::string key_;
+  bool started_ = false;
+  SubtreeBuilder capture_;
+  Target captureTarget_ = Target::Player;
+  Section captureSection_ = kRoot;
+
+  json rootScalars_ = json::object();
+  json worldScalars_ = json::object();
+  json character_;
+  MapPart maps_[2];
+  MapPart worldTiles_;  // world.tiles; its dims are in worldScalars_
+  Welcome sections_[2];
+};
+
+std::vector<std::string> parseOptionLabels(const json& options) {
+  std::vector<std::string> labels;
+  for (const auto& option : options) {
+    if (option.is_string()) {
+      labels.push_back(option.get<std::string>());
+    } else if (option.is_object()) {
+      const auto label = getStringField(option, {"label", "text", "name", "id"});
+      if (label.has_value() && !label->empty()) {
+        labels.push_back(label.value());
+      }
+    }
+  }
+  return labels;
+}
+
+WorldEvent decodeEvent(const json& msg, const std::string& type) {
+  const auto text = getStringField(msg, {"message", "text", "error"});
+  if (type == "error") {
+    return WorldError{text.value_or("Server error")};
+  }
+
+  if (type == "welcome") {
+    return decodeWelcome(msg);
+  }
+
+  if (type == "resumed") {
+    Resumed ev;
+    if (msg.contains("from_seq") && msg["from_seq"].is_number_unsigned()) {
+      ev.fromSeq = msg["from_seq"].get<std::uint64_t>();
+    }
+    if (const auto encoding = getStringField(msg, {"encoding"}); encoding.has_value()) {
+      ev.encoding = parseWireEncoding(*encoding);
+    }
+    return ev;
+  }
+
+  if (type == "interest_ack") {
+    InterestAck ev;
+    const auto x = getIntField(msg, {"x"});
+    const auto y = getIntField(msg, {"y"});
+    const auto w = getIntField(msg, {"w"});
+    const auto h = getIntField(msg, {"h"});
+    if (x && y && w && h) {
+      ev.hasArea = true;
+      ev.x = *x;
+      ev.y = *y;
+      ev.w = *w;
+      ev.h = *h;
+    }
+    return ev;
+  }
+
+  if (type == "interest_leave") {
+    InterestLeave ev;
+    parseIdList(msg, "players", ev.players);
+    parseIdList(msg, "mobs", ev.mobs);
+    return ev;
+  }
+
+  if (type == "player_joined" || type == "player_moved" || type == "player_update") {
+    const json& playerNode = (msg.contains("player") && msg["player"].is_object()) ? msg["player"] : msg;
+    PlayerUpsert ev;
+    ev.player = parsePlayer(playerNode);
+    ev.joined = type == "player_joined";
+    const auto ack = getIntField(msg, {"last_input_seq", "lastInputSeq", "ack_input_seq"});
+    ev.ackInputSeq = static_cast<std::uint32_t>(
+        std::max(0, ack.value_or(getIntField(playerNode, {"last_input_seq", "lastInputSeq"}).value_or(0))));
+    if (ev.player.id.empty()) {
+      return std::monostate{};
+    }
+    return ev;
+  }
+
+  if (type == "world_delta") {
+    WorldDelta ev;
+    const auto baseline = msg.find("baseline_seq");
+    if (baseline != msg.end() && baseline->is_number_unsigned()) {
+      ev.baselineSeq = baseline->get<std::uint64_t>();
+    }
+    ev.ackInputSeq = static_cast<std::uint32_t>(std::max(0, getIntField(msg, {"last_input_seq"}).value_or(0)));
+    parseEntityDeltas(msg, "players", ev.players);
+    parseEntityDeltas(msg, "mobs", ev.mobs);
+    parseIdList(msg, "removed_players", ev.removedPlayers);
+    parseIdList(msg, "removed_mobs", ev.removedMobs);
+    return ev;
+  }
+
+  if (type == "player_left") {
+    PlayerLeft ev{getStringField(msg, {"playerId", "id"}).value_or("")};
+    if (ev.id.empty()) {
+      return std::monostate{};
+    }
+    return ev;
+  }
+
+  if (type == "mob_update") {
+    MobUpsert ev;
+    if (msg.contains("mobs") && msg["mobs"].is_array()) {
+      ev.mobs = parseEntityList<MobState>(msg["mobs"], parseMob);
+    } else {
+      const json& mobNode = (msg.contains("mob") && msg["mob"].is_object()) ? msg["mob"] : msg;
+      MobState mob = parseMob(mobNode);
+      if (!mob.id.empty()) {
+        ev.mobs.push_back(std::move(mob));
+      }
+    }
+    return ev;
+  }
+
+  if (type == "combat") {
+    Combat ev;
+    ev.targetId = getStringField(msg, {"targetId", "mobId", "victimId"}).value_or("");
+    ev.damage = getIntField(msg, {"damage", "amount"}).value_or(0);
+    return ev;
+  }
+
+  if (type == "player_died") {
+    PlayerDied ev{getStringField(msg, {"playerId", "id"}).value_or("")};
+    if (ev.id.empty()) {
+      return std::monostate{};
+    }
+    return ev;
+  }
+
+  if (type == "dialog_start" || type == "dialog_update") {
+    const json& node = (msg.contains("node") && msg["node"].is_object()) ? msg["node"] : msg;
+    DialogStart ev;
+    DialogState& dialog = ev.dialog;
+    dialog.active = true;
+    dialog.npcId = getStringField(msg, {"npc_id", "npcId"}).value_or("");
+    dialog.npcName = getStringField(msg, {"npc_name", "npcName"}).value_or(dialog.npcId);
+    dialog.npcRole = getStringField(msg, {"npc_role", "npcRole"}).value_or("");
+    dialog.npcPortrait = getStringField(msg, {"npc_portrait", "npcPortrait"}).value_or("");
+    dialog.nodeId = getStringField(node, {"id", "node_id"}).value_or("");
+    dialog.text = getStringField(node, {"text", "message"}).value_or("");
+    dialog.responses = parseDialogResponses(node);
+    ev.questTrigger = getStringField(msg, {"quest_trigger", "questTrigger"}).value_or("");
+    return ev;
+  }
+
+  if (type == "dialog_end") {
+    DialogEnd ev;
+    ev.questTrigger = getStringField(msg, {"quest_trigger", "questTrigger"}).value_or("");
+    ev.npcName = getStringField(msg, {"npc_name", "npcName"}).value_or("");
+    ev.npcId = getStringField(msg, {"npc_id", "npcId"}).value_or("");
+    return ev;
+  }
+
+  if (type == "npc_response") {
+    NpcResponse ev;
+    ev.npcId = getStringField(msg, {"npcId", "id"}).value_or("");
+    if (msg.contains("result") && msg["result"].is_object()) {
+      const auto& result = msg["result"];
+      if (result.contains("text") && result["text"].is_string()) {
+        ev.text = result["text"].get<std::string>();
+      }
+      if (result.contains("options") && result["options"].is_array()) {
+        ev.options = parseOptionLabels(result["options"]);
+      }
+    }
+    if (ev.text.empty()) {
+      ev.text = getStringField(msg, {"text", "message"}).value_or("");
+    }
+    if (ev.options.empty() && msg.contains("options") && msg["options"].is_array()) {
+      ev.options = parseOptionLabels(msg["options"]);
+    }
+    return ev;
+  }
+
+  if (text.has_value() && !text->empty()) {
+    return ChatNotice{text.value()};
+  }
+  return std::monostate{};
+}
+
+json parseBinaryFrame(const std::string& raw) {
+  const auto marker = raw.empty() ? 0u : static_cast<unsigned char>(raw.front());
+  // MessagePack maps start with fixmap (0x80-0x8f) or map16/map32 (0xde/0xdf);
+  // CBOR maps use major type 5 (0xa0-0xbf).
+  if (marker >= 0xa0 && marker <= 0xbf) {
+    return json::from_cbor(raw);
+  }
+  return json::from_msgpack(raw);
+}
+
+std::atomic<std::size_t> gStreamingWelcomeThreshold{kDefaultStreamingWelcomeThreshold};
+
+bool decodeWelcomeStreaming(const std::string& raw, bool binary, DecodedMessage& out) {
+  // Cheap pre-check; strings appear verbatim in MessagePack and CBOR too.
+  if (raw.find("welcome") == std::string::npos) {
+    return false;
+  }
+  WelcomeSaxDecoder decoder;
+  try {
+    json::input_format_t format = json::input_format_t::json;
+    if (binary) {
+      const auto marker = raw.empty() ? 0u : static_cast<unsigned char>(raw.front());
+      format = (marker >= 0xa0 && marker <= 0xbf) ? json::input_format_t::cbor : json::input_format_t::msgpack;
+    }
+    return json::sax_parse(raw, &decoder, format) && decoder.finish(out);
+  } catch (const std::exception&) {
+    return false;
+  }
+}
+}  // namespace
+
+void setStreamingWelcomeThreshold(std::size_t bytes) {
+  gStreamingWelcomeThreshold.store(bytes, std::memory_order_relaxed);
+}
+
+std::optional<WireEncoding> parseWireEncoding(const std::string& name) {
+  if (name == "json") {
+    return WireEncoding::Json;
+  }
+  if (name == "msgpack") {
+    return WireEncoding::MsgPack;
+  }
+  if (name == "cbor") {
+    return WireEncoding::Cbor;
+  }
+  return std::nullopt;
+}
+
+const char* wireEncodingName(WireEncoding encoding) {
+  switch (encoding) {
+    case WireEncoding::MsgPack:
+      return "msgpack";
+    case WireEncoding::Cbor:
+      return "cbor";
+    default:
+      return "json";
+  }
+}
+
+std::string encodeWorldMessage(const json& msg, WireEncoding encoding) {
+  if (encoding == WireEncoding::MsgPack) {
+    std::string out;
+    json::to_msgpack(msg, out);
+    return out;
+  }
+  if (encoding == WireEncoding::Cbor) {
+    std::string out;
+    json::to_cbor(msg, out);
+    return out;
+  }
+  return msg.dump();
+}
+
+void decodeWorldMessage(const std::string& raw, bool binary, DecodedMessage& out) {
+  out.type.clear();
+  out.seq = 0;
+  out.serverTimeMs = 0;
+  if (raw.size() >= gStreamingWelcomeThreshold.load(std::memory_order_relaxed) &&
+      decodeWelcomeStreaming(raw, binary, out)) {
+    return;
+  }
+  try {
+    const json msg = binary ? parseBinaryFrame(raw) : json::parse(raw);
+    out.type = msg.value("type", "");
+    if (msg.contains("seq") && msg["seq"].is_number_unsigned()) {
+      out.seq = msg["seq"].get<std::uint64_t>();
+    }
+    out.serverTimeMs = parseServerTime(msg);
+    out.event = decodeEvent(msg, out.type);
+  } catch (const std::exception& ex) {
+    out.event = WorldError{std::string(binary ? "Invalid binary frame: " : "Invalid JSON: ") + ex.what()};
+  }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <optional>
+#include <string>
+
+#include "WorldEvents.hpp"
+#include "nlohmann/json_fwd.hpp"
+
+// Schema-tolerant field lookups shared by the world decoder and settings code.
+std::optional<std::string> getStringField(const nlohmann::json& j, std::initializer_list<const char*> keys);
+std::optional<int> getIntField(const nlohmann::json& j, std::initializer_list<const char*> keys);
+
+std::optional<WireEncoding> parseWireEncoding(const std::string& name);
+const char* wireEncodingName(WireEncoding encoding);
+
+// Decodes one world-socket payload into `out`. Binary frames may be
+// MessagePack or CBOR; the two are told apart by the leading map marker.
+// Never throws: malformed input yields a WorldError event. Thread-safe.
+void decodeWorldMessage(const std::string& raw, bool binary, DecodedMessage& out);
+
+// `welcome` frames at least this large are decoded with a streaming (SAX)
+// parser that never builds the whole-message DOM; anything else, or a frame
+// the streaming pass rejects, takes the DOM path. SIZE_MAX disables it.
+constexpr std::size_t kDefaultStreamingWelcomeThreshold = 64 * 1024;
+void setStreamingWelcomeThreshold(std::size_t bytes);
+
+// Serializes an outbound message. Json produces a text frame, the others binary.
+std::string encodeWorldMessage(const nlohmann::json& msg, WireEncoding encoding);
@@ -1,3 +1,4 @@
+#include "BotSwarm.hpp"
 #include "GameClient.hpp"
 
 #include <cstdlib>
@@ -23,15 +24,122 @@ std::string envChainOrDefault(const char* first, const char* second, const char*
   }
   return envOrDefault(second, fallback);
 }
+
+bool parseNumber(const std::string& text, double& out) {
+  if (text.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  const double value = std::strtod(text.c_str(), &end);
+  if (end == nullptr || *end != '\0' || value < 0.0) {
+    return false;
+  }
+  out = value;
+  return true;
+}
+
+bool parseCount(const std::string& text, int& out) {
+  double value = 0.0;
+  if (!parseNumber(text, value) || value != static_cast<double>(static_cast<int>(value))) {
+    return false;
+  }
+  out = static_cast<int>(value);
+  return true;
+}
+
+// Network conditioner knobs: CLI flag, environment fallback, target field.
+struct NetOption {
+  const char* flag;
+  const char* env;
+  void (*apply)(NetworkConditions&, double);
+};
+
+const NetOption kNetOptions[] = {
+    {"--net-delay-ms", "MMORP_NET_DELAY_MS", [](NetworkConditions& c, double v) { c.delayMs = static_cast<int>(v); }},
+    {"--net-jitter-ms", "MMORP_NET_JITTER_MS",
+     [](NetworkConditions& c, double v) { c.jitterMs = static_cast<int>(v); }},
+    {"--net-drop-pct", "MMORP_NET_DROP_PCT", [](NetworkConditions& c, double v) { c.dropPercent = v; }},
+    {"--net-reorder-pct", "MMORP_NET_REORDER_PCT", [](NetworkConditions& c, double v) { c.reorderPercent = v; }},
+    {"--net-bandwidth-kbps", "MMORP_NET_BANDWIDTH_KBPS",
+     [](NetworkConditions& c, double v) { c.bandwidthKbps = static_cast<int>(v); }},
+    {"--net-disconnect-every-s", "MMORP_NET_DISCONNECT_EVERY_S",
+     [](NetworkConditions& c, double v) { c.disconnectEverySec = static_cast<int>(v); }},
+};
+
+// Matches `--flag value` and `--flag=value`; advances `i` past a separate value.
+bool matchFlag(const std::string& arg, const char* flag, int& i, int argc, char** argv, std::string& value) {
+  const std::string name = flag;
+  if (arg == name && i + 1 < argc) {
+    value = argv[++i];
+    return true;
+  }
+  if (arg.rfind(name + "=", 0) == 0) {
+    value = arg.substr(name.size() + 1);
+    return true;
+  }
+  return false;
+}
 }  // namespace
 
 int main(int argc, char** argv) {
   std::string httpUrl = envChainOrDefault("MMORPG_HTTP_URL", "MMORP_HTTP_URL", kDefaultHttpUrl);
   std::string wsUrl = envChainOrDefault("MMORPG_WS_URL", "MMORP_WS_URL", kDefaultWsUrl);
 
+  ClientOptions options;
+  BotSwarmOptions bots;
+  NetworkConditions& netConditions = options.net;
+  for (const NetOption& option : kNetOptions) {
+    double value = 0.0;
+    const std::string env = envOrDefault(option.env, "");
+    if (!env.empty() && parseNumber(env, value)) {
+      option.apply(netConditions, value);
+    }
+  }
+
   for (int i = 1; i < argc; ++i) {
     const std::string arg = argv[i];
-    if (arg == "--http-url" && i + 1 < argc) {
+    const NetOption* netOption = nullptr;
+    std::string flagValue;
+    for (const NetOption& option : kNetOptions) {
+      if (matchFlag(arg, option.flag, i, argc, argv, flagValue)) {
+        netOption = &option;
+        break;
+      }
+    }
+    if (netOption != nullptr) {
+      double value = 0.0;
+      if (!parseNumber(flagValue, value)) {
+        std::cerr << "Invalid value for " << netOption->flag << ": " << flagValue << "\n";
+        return 1;
+      }
+      netOption->apply(netConditions, value);
+    } else if (matchFlag(arg, "--record", i, argc, argv, flagValue)) {
+      options.recordPath = flagValue;
+    } else if (matchFlag(arg, "--replay", i, argc, argv, flagValue)) {
+      options.replayPath = flagValue;
+    } else if (matchFlag(arg, "--replay-speed", i, argc, argv, flagValue)) {
+      if (flagValue == "max") {
+        options.replaySpeed = 0.0;
+      } else if (!parseNumber(flagValue, options.replaySpeed) || options.replaySpeed <= 0.0) {
+        std::cerr << "Invalid value for --replay-speed: " << flagValue << "\n";
+        return 1;
+      }
+    } else if (matchFlag(arg, "--bots", i, argc, argv, flagValue)) {
+      if (!parseCount(flagValue, bots.bots)) {
+        std::cerr << "Invalid value for --bots: " << flagValue << "\n";
+        return 1;
+      }
+    } else if (matchFlag(arg, "--bot-threads", i, argc, argv, flagValue)) {
+      if (!parseCount(flagValue, bots.threads)) {
+        std::cerr << "Invalid value for --bot-threads: " << flagValue << "\n";
+        return 1;
+      }
+    } else if (matchFlag(arg, "--bot-duration", i, argc, argv, flagValue)) {
+      if (!parseCount(flagValue, bots.durationSec)) {
+        std::cerr << "Invalid value for --bot-duration: " << flagValue << "\n";
+        return 1;
+      }
+    } else if (arg == "--http-url" && i + 1 < argc) {
       httpUrl = argv[++i];
     } else if (arg.rfind("--http-url=", 0) == 0) {
       httpUrl = arg.substr(std::string("--http-url=").size());
@@ -40,10 +148,17 @@ int main(int argc, char** argv) {
     } else if (arg.rfind("--ws-url=", 0) == 0) {
       wsUrl = arg.substr(std::string("--ws-url=").size());
     } else if (arg == "--help" || arg == "-h") {
-      std::cout << "Usage: mmorp-client [--http-url URL] [--ws-url URL]\n"
+      std::cout << "Usage: mmorp-client [--http-url URL] [--ws-url URL] [--record FILE]\n"
+                << "                    [--replay FILE [--replay-speed X|max]] [network conditioner options]\n"
+                << "       mmorp-client --bots N [--bot-threads K] [--bot-duration SECONDS]\n"
+                << "                    (headless load test; duration 0 runs until Ctrl+C, default 60)\n"
                 << "Environment fallbacks:\n"
                 << "  MMORPG_HTTP_URL / MMORP_HTTP_URL (default: " << kDefaultHttpUrl << ")\n"
-                << "  MMORPG_WS_URL   / MMORP_WS_URL   (default: " << kDefaultWsUrl << ")\n";
+                << "  MMORPG_WS_URL   / MMORP_WS_URL   (default: " << kDefaultWsUrl << ")\n"
+                << "Network conditioner (debugging; all default to 0 = off):\n";
+      for (const NetOption& option : kNetOptions) {
+        std::cout << "  " << option.flag << " N  (env " << option.env << ")\n";
+      }
       return 0;
     } else {
       std::cerr << "Unknown argument: " << arg << "\n";
@@ -52,7 +167,13 @@ int main(int argc, char** argv) {
     }
   }
 
-  GameClient client(httpUrl, wsUrl);
+  if (bots.bots > 0) {
+    bots.httpUrl = httpUrl;
+    bots.wsUrl = wsUrl;
+    return runBotSwarm(bots);
+  }
+
+  GameClient client(httpUrl, wsUrl, options);
   client.run();
   return 0;
 }
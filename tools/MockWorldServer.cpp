@@ -0,0 +1,1360 @@
+// Stand-in backend for local load and latency testing.
+//
+// Serves the auth and character routes with cpp-httplib and the world socket
+// with a websocketpp server, then simulates a zone around whoever joins:
+// wandering players (`player_joined` / `player_moved` / `player_left`), mobs
+// (`mob_update`), random fights (`combat`) and a talkative NPC (`dialog_*`).
+// A client that sends `interest` gets an `interest_ack` and from then on only
+// position updates for entities inside its area, plus the one that takes an
+// entity out; entities the area moves away from are listed in `interest_leave`.
+// Every message carries a per-session `seq`. A closed session is kept for
+// kResumeGraceSec, and a `join` with `last_seq` gets `resumed` plus a replay
+// of what it missed. `encodings` in the join picks MessagePack or CBOR;
+// binary frames from the client are accepted either way.
+// The simulation is driven by tick count and its own seeded RNG, so a given
+// seed and scenario replay the same world; only client actions (attacks) can
+// perturb it.
+//
+//   mock_world_server [--http-port 8080] [--ws-port 8081] [--seed 1]
+//                     [--tick-hz 10] [--map 64x64] [--npcs 3]
+//                     [--players 50] [--mobs 20] [--move-pct 30]
+//                     [--mob-move-pct 20] [--combat-per-s 4]
+//                     [--crowd X,Y,R] [--scenario FILE] [--deflate]
+//
+// --deflate accepts permessage-deflate offers (builds with MMORP_WS_DEFLATE
+// only); the stats line then reports payload and compressed wire rates.
+//
+// A scenario file is JSON; top-level keys mirror the flags and `phases` change
+// the crowd over time:
+//
+//   {"seed": 7, "tick_hz": 20, "map": {"width": 96, "height": 96},
+//    "phases": [{"at_s": 0, "players": 20, "mobs": 10},
+//               {"at_s": 15, "players": 400, "move_pct": 80,
+//                "crowd": {"x": 48, "y": 48, "radius": 4}},
+//               {"at_s": 60, "players": 50, "crowd": null}]}
+//
+// Point the client at it with
+//   mmorp_client --http-url http://localhost:8080 --ws-url ws://localhost:8081/v1/world/ws
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/server.hpp>
+#if MMORP_WS_DEFLATE
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
+#endif
+
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+
+namespace {
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+// Bytes the server compressed: payload before deflate, frame payload after.
+// One endpoint per process, all on its io thread.
+struct DeflateTotals {
+  std::uint64_t payload = 0;
+  std::uint64_t wire = 0;
+};
+
+DeflateTotals& deflateTotals() {
+  static DeflateTotals totals;
+  return totals;
+}
+
+#if MMORP_WS_DEFLATE
+// permessage-deflate that declines offers unless --deflate was given and
+// counts what it compresses. The processor calls these on the concrete type.
+template <typename config>
+class SwitchableDeflate : public websocketpp::extensions::permessage_deflate::enabled<config> {
+ public:
+  using base = websocketpp::extensions::permessage_deflate::enabled<config>;
+
+  static bool& accept() {
+    static bool enabled = false;
+    return enabled;
+  }
+
+  websocketpp::err_str_pair negotiate(websocketpp::http::attribute_list const& offer) {
+    if (!accept()) {
+      // The handshake goes on without the extension.
+      return websocketpp::err_str_pair(websocketpp::extensions::permessage_deflate::error::make_error_code(
+                                           websocketpp::extensions::permessage_deflate::error::general),
+                                       std::string());
+    }
+    return base::negotiate(offer);
+  }
+
+  websocketpp::lib::error_code compress(std::string const& in, std::string& out) {
+    const std::size_t before = out.size();
+    const auto ec = base::compress(in, out);
+    deflateTotals().payload += in.size();
+    deflateTotals().wire += out.size() - before;
+    return ec;
+  }
+};
+
+struct MockServerConfig : public websocketpp::config::asio {
+  typedef MockServerConfig type;
+  typedef websocketpp::config::asio base;
+
+  typedef base::concurrency_type concurrency_type;
+  typedef base::request_type request_type;
+  typedef base::response_type response_type;
+  typedef base::message_type message_type;
+  typedef base::con_msg_manager_type con_msg_manager_type;
+  typedef base::endpoint_msg_manager_type endpoint_msg_manager_type;
+  typedef base::alog_type alog_type;
+  typedef base::elog_type elog_type;
+  typedef base::rng_type rng_type;
+  typedef base::transport_type transport_type;
+
+  typedef SwitchableDeflate<base::permessage_deflate_config> permessage_deflate_type;
+};
+using WsServer = websocketpp::server<MockServerConfig>;
+#else
+using WsServer = websocketpp::server<websocketpp::config::asio>;
+#endif
+
+constexpr const char* kWorldPath = "/v1/world/ws";
+constexpr int kMobRespawnTicks = 50;
+constexpr int kStatsEverySec = 5;
+constexpr int kSpawnTries = 64;
+constexpr std::size_t kResumeBacklog = 4096;  // messages kept per session for a resume
+constexpr int kResumeGraceSec = 30;
+
+enum class Encoding { Json, MsgPack, Cbor };
+
+// First encoding in the client's `encodings` the mock speaks; JSON otherwise.
+Encoding pickEncoding(const json& offered) {
+  if (offered.is_array()) {
+    for (const json& name : offered) {
+      if (name == "msgpack") {
+        return Encoding::MsgPack;
+      }
+      if (name == "cbor") {
+        return Encoding::Cbor;
+      }
+      if (name == "json") {
+        return Encoding::Json;
+      }
+    }
+  }
+  return Encoding::Json;
+}
+
+const char* encodingName(Encoding encoding) {
+  switch (encoding) {
+    case Encoding::MsgPack:
+      return "msgpack";
+    case Encoding::Cbor:
+      return "cbor";
+    case Encoding::Json:
+      break;
+  }
+  return "json";
+}
+
+std::string encodeBinary(const json& msg, Encoding encoding) {
+  const std::vector<std::uint8_t> bytes = encoding == Encoding::Cbor ? json::to_cbor(msg) : json::to_msgpack(msg);
+  return std::string(bytes.begin(), bytes.end());
+}
+
+// Discarded (not an object) when the frame does not parse.
+json decodeFrame(const std::string& payload, bool binary) {
+  if (!binary) {
+    return json::parse(payload, nullptr, false);
+  }
+  if (payload.empty()) {
+    return json();
+  }
+  // CBOR maps start at 0xa0-0xbf; MessagePack maps at 0x80-0x8f, 0xde or 0xdf.
+  const auto lead = static_cast<unsigned char>(payload[0]);
+  if (lead >= 0xa0 && lead <= 0xbf) {
+    return json::from_cbor(payload, true, false);
+  }
+  return json::from_msgpack(payload, true, false);
+}
+
+struct Crowd {
+  int x = 0;
+  int y = 0;
+  int radius = 3;
+};
+
+// Targets in force from `atSec` on. Unset fields keep the previous phase's value.
+struct Phase {
+  double atSec = 0.0;
+  std::optional<int> players;
+  std::optional<int> mobs;
+  std::optional<double> movePct;
+  std::optional<double> mobMovePct;
+  std::optional<double> combatPerSec;
+  bool setsCrowd = false;
+  std::optional<Crowd> crowd;
+};
+
+struct Options {
+  int httpPort = 8080;
+  int wsPort = 8081;
+  std::uint32_t seed = 1;
+  double tickHz = 10.0;
+  int mapWidth = 64;
+  int mapHeight = 64;
+  int npcs = 3;
+  bool deflate = false;
+  Phase base{0.0, 50, 20, 30.0, 20.0, 4.0, true, std::nullopt};
+  std::vector<Phase> phases;
+};
+
+std::int64_t serverTimeMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string bearerToken(const std::string& authorization) {
+  constexpr const char* kPrefix = "Bearer ";
+  if (authorization.rfind(kPrefix, 0) != 0) {
+    return {};
+  }
+  return authorization.substr(7);
+}
+
+// Users and their characters. Shared between the HTTP worker threads and the
+// websocket thread (token checks), hence the mutex.
+class AccountStore {
+ public:
+  std::string login(const std::string& email) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::string token = "mock." + email;
+    characters_.try_emplace(token, json::array());
+    return token;
+  }
+
+  std::optional<std::string> registerUser(const std::string& email) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::string token = "mock." + email;
+    if (!characters_.try_emplace(token, json::array()).second) {
+      return std::nullopt;
+    }
+    return token;
+  }
+
+  bool knows(const std::string& token) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return characters_.count(token) > 0;
+  }
+
+  std::optional<json> list(const std::string& token) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = characters_.find(token);
+    if (it == characters_.end()) {
+      return std::nullopt;
+    }
+    return json{{"items", it->second}};
+  }
+
+  std::optional<json> create(const std::string& token, const std::string& name, const std::string& className) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = characters_.find(token);
+    if (it == characters_.end()) {
+      return std::nullopt;
+    }
+    json character{{"id", "c" + std::to_string(++nextCharacterId_)}, {"name", name}, {"class", className}};
+    it->second.push_back(character);
+    return character;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, json> characters_;  // token -> array of characters
+  std::uint64_t nextCharacterId_ = 0;
+};
+
+void installHttpRoutes(httplib::Server& http, AccountStore& accounts) {
+  const auto credentials = [](const httplib::Request& req, httplib::Response& res) -> std::optional<std::string> {
+    const json body = json::parse(req.body, nullptr, false);
+    const std::string email = body.is_object() ? body.value("email", body.value("username", "")) : "";
+    if (email.empty()) {
+      res.status = 400;
+      res.set_content(R"({"error":"email required"})", "application/json");
+      return std::nullopt;
+    }
+    return email;
+  };
+
+  http.Post("/v1/auth/login", [&accounts, credentials](const httplib::Request& req, httplib::Response& res) {
+    if (const auto email = credentials(req, res)) {
+      res.set_content(json{{"token", accounts.login(*email)}}.dump(), "application/json");
+    }
+  });
+
+  http.Post("/v1/auth/register", [&accounts, credentials](const httplib::Request& req, httplib::Response& res) {
+    const auto email = credentials(req, res);
+    if (!email) {
+      return;
+    }
+    const auto token = accounts.registerUser(*email);
+    if (!token) {
+      res.status = 409;
+      res.set_content(R"({"error":"already registered"})", "application/json");
+      return;
+    }
+    res.status = 201;
+    res.set_content(json{{"token", *token}}.dump(), "application/json");
+  });
+
+  http.Get("/v1/characters", [&accounts](const httplib::Request& req, httplib::Response& res) {
+    const auto items = accounts.list(bearerToken(req.get_header_value("Authorization")));
+    if (!items) {
+      res.status = 401;
+      return;
+    }
+    const std::string body = items->dump();
+    const std::string etag = "\"" + std::to_string(std::hash<std::string>{}(body)) + "\"";
+    res.set_header("ETag", etag);
+    if (req.get_header_value("If-None-Match") == etag) {
+      res.status = 304;
+      return;
+    }
+    res.set_content(body, "application/json");
+  });
+
+  http.Post("/v1/characters", [&accounts](const httplib::Request& req, httplib::Response& res) {
+    const json body = json::parse(req.body, nullptr, false);
+    const std::string name = body.is_object() ? body.value("name", "") : "";
+    if (name.empty()) {
+      res.status = 400;
+      return;
+    }
+    const auto character =
+        accounts.create(bearerToken(req.get_header_value("Authorization")), name, body.value("class", "Warrior"));
+    if (!character) {
+      res.status = 401;
+      return;
+    }
+    res.status = 201;
+    res.set_content(character->dump(), "application/json");
+  });
+}
+
+struct Entity {
+  std::string id;
+  std::string name;
+  std::string className;
+  int x = 0;
+  int y = 0;
+  int hp = 100;
+  int maxHp = 100;
+  bool alive = true;
+  bool aggressive = false;
+  std::uint64_t respawnTick = 0;
+};
+
+json playerJson(const Entity& p) {
+  return {{"id", p.id},       {"name", p.name}, {"class", p.className}, {"x", p.x},
+          {"y", p.y},         {"hp", p.hp},     {"maxHP", p.maxHp},     {"alive", p.alive}};
+}
+
+json mobJson(const Entity& m) {
+  return {{"id", m.id}, {"name", m.name},     {"x", m.x},         {"y", m.y},
+          {"hp", m.hp}, {"maxHP", m.maxHp}, {"alive", m.alive}, {"aggressive", m.aggressive}};
+}
+
+struct Area {
+  int x = 0;
+  int y = 0;
+  int w = 0;
+  int h = 0;
+
+  bool contains(int px, int py) const { return px >= x && py >= y && px < x + w && py < y + h; }
+};
+
+struct Session {
+  bool joined = false;
+  Entity player;
+  std::optional<Area> interest;  // set by `interest`; until then everything is sent
+  std::unordered_set<std::string> inView;  // last sent inside `interest`; the client expects news of these
+  Encoding encoding = Encoding::Json;      // agreed in the last welcome/resumed
+  std::uint64_t seq = 0;                   // of the last message sent
+  std::deque<std::pair<std::uint64_t, std::string>> backlog;  // recent messages as sent in JSON, for a resume
+  std::optional<Clock::time_point> parkedUntil;  // socket closed; the player stays until then
+};
+
+// The simulated zone. Everything here runs on the websocket io thread.
+class Zone {
+ public:
+  Zone(WsServer& server, AccountStore& accounts, const Options& options)
+      : server_(server), accounts_(accounts), options_(options), rng_(options.seed), reactions_(options.seed ^ 0x9e3779b9u) {
+    buildMap();
+    for (int i = 0; i < options_.npcs; ++i) {
+      Entity npc;
+      npc.id = "npc-" + std::to_string(i + 1);
+      npc.name = i == 0 ? "Elder Maren" : "Villager " + std::to_string(i);
+      placeRandomly(npc, rng_);
+      npcs_.push_back(npc);
+    }
+    phase_ = options_.base;
+    applyTargets();
+  }
+
+  bool validate(websocketpp::connection_hdl hdl) {
+    const auto con = server_.get_con_from_hdl(hdl);
+    const std::string resource = con->get_resource();
+    if (resource.rfind(kWorldPath, 0) != 0) {
+      con->set_status(websocketpp::http::status_code::not_found);
+      return false;
+    }
+    std::string token = bearerToken(con->get_request_header("Authorization"));
+    const auto query = resource.find("token=");
+    if (token.empty() && query != std::string::npos) {
+      token = resource.substr(query + 6, resource.find('&', query) - (query + 6));
+    }
+    if (!accounts_.knows(token)) {
+      con->set_status(websocketpp::http::status_code::unauthorized);
+      return false;
+    }
+    return true;
+  }
+
+  void onOpen(websocketpp::connection_hdl hdl) { sessions_.emplace(hdl, Session{}); }
+
+  // A joined session is parked rather than dropped, so the client can resume
+  // it; it keeps collecting messages until the grace period ends.
+  void onClose(websocketpp::connection_hdl hdl) {
+    const auto it = sessions_.find(hdl);
+    if (it == sessions_.end()) {
+      return;
+    }
+    if (!it->second.joined) {
+      sessions_.erase(it);
+      return;
+    }
+    it->second.parkedUntil = Clock::now() + std::chrono::seconds(kResumeGraceSec);
+  }
+
+  void onMessage(websocketpp::connection_hdl hdl, WsServer::message_ptr msg) {
+    const auto it = sessions_.find(hdl);
+    const auto opcode = msg->get_opcode();
+    if (it == sessions_.end() ||
+        (opcode != websocketpp::frame::opcode::text && opcode != websocketpp::frame::opcode::binary)) {
+      return;
+    }
+    const json in = decodeFrame(msg->get_payload(), opcode == websocketpp::frame::opcode::binary);
+    if (!in.is_object()) {
+      return;
+    }
+    Session& session = it->second;
+    const std::string type = in.value("type", "");
+    if (type == "join" || type == "join_world") {
+      handleJoin(hdl, session, in);
+    } else if (!session.joined) {
+      send(hdl, {{"type", "error"}, {"message", "join first"}});
+    } else if (type == "move") {
+      handleMove(session, in);
+    } else if (type == "attack") {
+      handleAttack(session, in.value("targetId", in.value("mobId", "")));
+    } else if (type == "interact") {
+      handleInteract(hdl, in.value("npcId", ""));
+    } else if (type == "dialog_select") {
+      handleDialogSelect(hdl, in.value("npcId", ""), in.value("response_id", ""));
+    } else if (type == "interest") {
+      handleInterest(hdl, session, in);
+    } else if (type == "resync_request") {
+      sendWelcome(hdl, session);
+    }
+  }
+
+  void start() {
+    startedAt_ = Clock::now();
+    nextTickAt_ = startedAt_;
+    scheduleTick();
+  }
+
+ private:
+  bool walkable(int x, int y) const {
+    if (x < 0 || y < 0 || x >= options_.mapWidth || y >= options_.mapHeight) {
+      return false;
+    }
+    const char tile = rows_[static_cast<std::size_t>(y)][static_cast<std::size_t>(x)];
+    return tile == 'g' || tile == 'f';
+  }
+
+  void buildMap() {
+    const int w = options_.mapWidth;
+    const int h = options_.mapHeight;
+    rows_.assign(static_cast<std::size_t>(h), std::string(static_cast<std::size_t>(w), 'g'));
+    for (int y = 0; y < h; ++y) {
+      for (int x = 0; x < w; ++x) {
+        if (x == 0 || y == 0 || x == w - 1 || y == h - 1) {
+          rows_[static_cast<std::size_t>(y)][static_cast<std::size_t>(x)] = '#';
+        }
+      }
+    }
+    const int patches = std::max(1, w * h / 256);
+    std::uniform_int_distribution<int> px(1, std::max(1, w - 2));
+    std::uniform_int_distribution<int> py(1, std::max(1, h - 2));
+    std::uniform_int_distribution<int> radius(1, 3);
+    for (int i = 0; i < patches; ++i) {
+      const char tile = i % 2 == 0 ? 'w' : 'f';
+      const int cx = px(rng_);
+      const int cy = py(rng_);
+      const int r = radius(rng_);
+      for (int y = std::max(1, cy - r); y <= std::min(h - 2, cy + r); ++y) {
+        for (int x = std::max(1, cx - r); x <= std::min(w - 2, cx + r); ++x) {
+          if ((x - cx) * (x - cx) + (y - cy) * (y - cy) <= r * r) {
+            rows_[static_cast<std::size_t>(y)][static_cast<std::size_t>(x)] = tile;
+          }
+        }
+      }
+    }
+  }
+
+  void placeRandomly(Entity& e, std::mt19937& rng) {
+    int minX = 1;
+    int minY = 1;
+    int maxX = options_.mapWidth - 2;
+    int maxY = options_.mapHeight - 2;
+    if (phase_.crowd) {
+      minX = std::max(minX, phase_.crowd->x - phase_.crowd->radius);
+      minY = std::max(minY, phase_.crowd->y - phase_.crowd->radius);
+      maxX = std::min(maxX, phase_.crowd->x + phase_.crowd->radius);
+      maxY = std::min(maxY, phase_.crowd->y + phase_.crowd->radius);
+    }
+    std::uniform_int_distribution<int> dx(minX, std::max(minX, maxX));
+    std::uniform_int_distribution<int> dy(minY, std::max(minY, maxY));
+    for (int i = 0; i < kSpawnTries; ++i) {
+      e.x = dx(rng);
+      e.y = dy(rng);
+      if (walkable(e.x, e.y)) {
+        return;
+      }
+    }
+  }
+
+  // One tile step: toward the crowd centre when outside it, otherwise random.
+  void wander(Entity& e) {
+    int dx = 0;
+    int dy = 0;
+    std::uniform_int_distribution<int> pick(0, 3);
+    const int dir = pick(rng_);
+    if (phase_.crowd && std::abs(e.x - phase_.crowd->x) + std::abs(e.y - phase_.crowd->y) > phase_.crowd->radius &&
+        dir != 0) {
+      dx = (phase_.crowd->x > e.x) - (phase_.crowd->x < e.x);
+      dy = dx == 0 ? (phase_.crowd->y > e.y) - (phase_.crowd->y < e.y) : 0;
+    } else {
+      dx = dir == 0 ? 1 : dir == 1 ? -1 : 0;
+      dy = dir == 2 ? 1 : dir == 3 ? -1 : 0;
+    }
+    if (walkable(e.x + dx, e.y + dy)) {
+      e.x += dx;
+      e.y += dy;
+    }
+  }
+
+  bool chance(double pct) {
+    std::uniform_real_distribution<double> roll(0.0, 100.0);
+    return roll(rng_) < pct;
+  }
+
+  void applyTargets() {
+    const int players = std::max(0, phase_.players.value_or(0));
+    while (static_cast<int>(bots_.size()) > players) {
+      broadcast({{"type", "player_left"}, {"playerId", bots_.back().id}});
+      forget(bots_.back().id);
+      bots_.pop_back();
+    }
+    static const char* const kClasses[] = {"Warrior", "Mage", "Rogue"};
+    while (static_cast<int>(bots_.size()) < players) {
+      Entity bot;
+      bot.id = "bot-" + std::to_string(++nextBotId_);
+      bot.name = "Bot" + std::to_string(nextBotId_);
+      bot.className = kClasses[nextBotId_ % 3];
+      placeRandomly(bot, rng_);
+      bots_.push_back(bot);
+      broadcast({{"type", "player_joined"}, {"player", playerJson(bot)}});
+      noteSent(bot);
+    }
+
+    const int mobs = std::max(0, phase_.mobs.value_or(0));
+    json changed = json::array();
+    while (static_cast<int>(mobs_.size()) > mobs) {
+      mobs_.back().alive = false;
+      mobs_.back().hp = 0;
+      changed.push_back(mobJson(mobs_.back()));
+      forget(mobs_.back().id);
+      mobs_.pop_back();
+    }
+    static const char* const kMobNames[] = {"Slime", "Wolf", "Goblin", "Bat"};
+    while (static_cast<int>(mobs_.size()) < mobs) {
+      Entity mob;
+      mob.id = "mob-" + std::to_string(++nextMobId_);
+      mob.name = kMobNames[nextMobId_ % 4];
+      mob.maxHp = mob.hp = 40 + static_cast<int>(nextMobId_ % 4) * 20;
+      mob.aggressive = nextMobId_ % 3 == 0;
+      placeRandomly(mob, rng_);
+      mobs_.push_back(mob);
+      changed.push_back(mobJson(mob));
+    }
+    if (!changed.empty()) {
+      broadcastMobs(std::move(changed));
+    }
+  }
+
+  void enterDuePhases(double simSec) {
+    bool entered = false;
+    while (nextPhase_ < options_.phases.size() && options_.phases[nextPhase_].atSec <= simSec) {
+      const Phase& next = options_.phases[nextPhase_++];
+      phase_.players = next.players ? next.players : phase_.players;
+      phase_.mobs = next.mobs ? next.mobs : phase_.mobs;
+      phase_.movePct = next.movePct ? next.movePct : phase_.movePct;
+      phase_.mobMovePct = next.mobMovePct ? next.mobMovePct : phase_.mobMovePct;
+      phase_.combatPerSec = next.combatPerSec ? next.combatPerSec : phase_.combatPerSec;
+      if (next.setsCrowd) {
+        phase_.crowd = next.crowd;
+      }
+      std::printf("[mock] phase at %.1fs: players=%d mobs=%d crowd=%s\n", next.atSec, phase_.players.value_or(0),
+                  phase_.mobs.value_or(0), phase_.crowd ? "on" : "off");
+      entered = true;
+    }
+    if (entered) {
+      applyTargets();
+    }
+  }
+
+  void tick() {
+    ++tick_;
+    enterDuePhases(static_cast<double>(tick_) / options_.tickHz);
+    expireParked();
+
+    for (Entity& bot : bots_) {
+      if (chance(phase_.movePct.value_or(0.0))) {
+        wander(bot);
+        broadcastAt(bot, {{"type", "player_moved"}, {"player", playerJson(bot)}});
+      }
+    }
+
+    std::vector<std::size_t> touched;
+    for (std::size_t i = 0; i < mobs_.size(); ++i) {
+      Entity& mob = mobs_[i];
+      if (!mob.alive && tick_ >= mob.respawnTick) {
+        mob.alive = true;
+        mob.hp = mob.maxHp;
+        placeRandomly(mob, rng_);
+        touched.push_back(i);
+      } else if (mob.alive && chance(phase_.mobMovePct.value_or(0.0))) {
+        wander(mob);
+        touched.push_back(i);
+      }
+    }
+
+    combatBudget_ += phase_.combatPerSec.value_or(0.0) / options_.tickHz;
+    std::uniform_int_distribution<int> damage(3, 18);
+    while (combatBudget_ >= 1.0 && !bots_.empty() && !mobs_.empty()) {
+      combatBudget_ -= 1.0;
+      const std::size_t target = std::uniform_int_distribution<std::size_t>(0, mobs_.size() - 1)(rng_);
+      const std::string& attacker = bots_[std::uniform_int_distribution<std::size_t>(0, bots_.size() - 1)(rng_)].id;
+      if (hitMob(mobs_[target], attacker, damage(rng_))) {
+        touched.push_back(target);
+      }
+    }
+    combatBudget_ = std::min(combatBudget_, 1.0);
+
+    if (!touched.empty()) {
+      std::sort(touched.begin(), touched.end());
+      touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+      json changed = json::array();
+      for (const std::size_t i : touched) {
+        changed.push_back(mobJson(mobs_[i]));
+      }
+      broadcastMobs(std::move(changed));
+    }
+
+    if (tick_ % static_cast<std::uint64_t>(std::max(1.0, options_.tickHz * kStatsEverySec)) == 0) {
+      reportStats();
+    }
+  }
+
+  bool hitMob(Entity& mob, const std::string& attackerId, int amount) {
+    if (!mob.alive) {
+      return false;
+    }
+    mob.hp = std::max(0, mob.hp - amount);
+    if (mob.hp == 0) {
+      mob.alive = false;
+      mob.respawnTick = tick_ + kMobRespawnTicks;
+    }
+    broadcast({{"type", "combat"}, {"attackerId", attackerId}, {"targetId", mob.id}, {"damage", amount}});
+    return true;
+  }
+
+  void scheduleTick() {
+    nextTickAt_ += std::chrono::microseconds(static_cast<std::int64_t>(1e6 / options_.tickHz));
+    const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextTickAt_ - Clock::now()).count();
+    server_.set_timer(std::max<long>(0, static_cast<long>(wait)), [this](const websocketpp::lib::error_code& ec) {
+      if (ec) {
+        return;
+      }
+      tick();
+      scheduleTick();
+    });
+  }
+
+  json welcomeFor(const Session& session) const {
+    json players = json::array();
+    for (const Entity& bot : bots_) {
+      players.push_back(playerJson(bot));
+    }
+    for (const auto& [hdl, other] : sessions_) {
+      if (other.joined) {
+        players.push_back(playerJson(other.player));
+      }
+    }
+    json npcs = json::array();
+    for (const Entity& npc : npcs_) {
+      npcs.push_back({{"id", npc.id}, {"name", npc.name}, {"role", "villager"}, {"x", npc.x}, {"y", npc.y}});
+    }
+    json mobs = json::array();
+    for (const Entity& mob : mobs_) {
+      mobs.push_back(mobJson(mob));
+    }
+    return {{"type", "welcome"},
+            {"playerId", session.player.id},
+            {"encoding", encodingName(session.encoding)},
+            {"character", {{"pos_x", session.player.x}, {"pos_y", session.player.y}}},
+            {"world",
+             {{"map", {{"width", options_.mapWidth}, {"height", options_.mapHeight}, {"tiles", rows_}}},
+              {"players", std::move(players)},
+              {"npcs", std::move(npcs)},
+              {"mobs", std::move(mobs)}}}};
+  }
+
+  // The welcome carries every entity, so all of them count as sent.
+  void sendWelcome(websocketpp::connection_hdl hdl, Session& session) {
+    send(hdl, welcomeFor(session));
+    if (!session.interest) {
+      return;
+    }
+    for (const Entity& mob : mobs_) {
+      session.inView.insert(mob.id);
+    }
+    forEachPlayer(session, [&](const Entity& player) { session.inView.insert(player.id); });
+  }
+
+  void handleJoin(websocketpp::connection_hdl hdl, Session& session, const json& in) {
+    session.encoding = pickEncoding(in.value("encodings", json::array()));
+    if (session.joined) {
+      sendWelcome(hdl, session);
+      return;
+    }
+    const std::string id = "p-" + in.value("character_id", std::to_string(++nextGuestId_));
+    const json lastSeq = in.value("last_seq", json());
+    if (lastSeq.is_number_unsigned() && resume(hdl, session, id, lastSeq.get<std::uint64_t>())) {
+      return;
+    }
+    dropSessionsOf(id, session);
+    Entity& player = session.player;
+    player.id = id;
+    player.name = in.value("name", player.id);
+    player.className = in.value("class", in.value("character", "Warrior"));
+    placeRandomly(player, reactions_);
+    session.joined = true;
+    send(hdl, welcomeFor(session));
+    broadcast({{"type", "player_joined"}, {"player", playerJson(player)}}, hdl);
+    noteSent(player);
+  }
+
+  // Moves the session `id` left on another connection onto this one, then
+  // replays what came after `lastSeq`. False when there is no such session or
+  // its backlog no longer reaches back that far.
+  bool resume(websocketpp::connection_hdl hdl, Session& session, const std::string& id, std::uint64_t lastSeq) {
+    const auto prior = std::find_if(sessions_.begin(), sessions_.end(), [&](const auto& entry) {
+      return &entry.second != &session && entry.second.joined && entry.second.player.id == id;
+    });
+    if (prior == sessions_.end()) {
+      return false;
+    }
+    const auto& backlog = prior->second.backlog;
+    const std::uint64_t oldest = backlog.empty() ? prior->second.seq + 1 : backlog.front().first;
+    if (lastSeq > prior->second.seq || lastSeq + 1 < oldest) {
+      return false;
+    }
+    const Encoding encoding = session.encoding;
+    closeIfLive(prior);
+    session = std::move(prior->second);
+    session.encoding = encoding;
+    session.parkedUntil.reset();
+    sessions_.erase(prior);
+
+    // Not sequenced: it must not overtake the replay in the client's dedupe.
+    json resumed{{"type", "resumed"}, {"from_seq", lastSeq}, {"encoding", encodingName(encoding)}};
+    stamp(resumed);
+    transmit(hdl, encoding, resumed.dump());
+    for (const auto& [seq, text] : session.backlog) {
+      if (seq > lastSeq) {
+        transmit(hdl, encoding, text);
+      }
+    }
+    return true;
+  }
+
+  // Sessions of the same character on other connections: one the client gave
+  // up on, parked or half-open. A fresh join replaces them.
+  void dropSessionsOf(const std::string& id, const Session& keep) {
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+      if (&it->second != &keep && it->second.joined && it->second.player.id == id) {
+        it = retire(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  using SessionMap = std::map<websocketpp::connection_hdl, Session, std::owner_less<websocketpp::connection_hdl>>;
+
+  void closeIfLive(SessionMap::iterator it) {
+    if (!it->second.parkedUntil) {
+      websocketpp::lib::error_code ec;
+      server_.close(it->first, websocketpp::close::status::going_away, "session moved", ec);
+    }
+  }
+
+  SessionMap::iterator retire(SessionMap::iterator it) {
+    closeIfLive(it);
+    return sessions_.erase(it);
+  }
+
+  void expireParked() {
+    const auto now = Clock::now();
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+      if (!it->second.parkedUntil || *it->second.parkedUntil > now) {
+        ++it;
+        continue;
+      }
+      const std::string id = it->second.player.id;
+      it = sessions_.erase(it);
+      broadcast({{"type", "player_left"}, {"playerId", id}});
+      forget(id);
+    }
+  }
+
+  void handleMove(Session& session, const json& in) {
+    Entity& player = session.player;
+    const int dx = std::clamp(in.value("dx", 0), -1, 1);
+    const int dy = std::clamp(in.value("dy", 0), -1, 1);
+    if (walkable(player.x + dx, player.y + dy)) {
+      player.x += dx;
+      player.y += dy;
+    }
+    json moved{{"type", "player_moved"}, {"player", playerJson(player)}};
+    if (in.contains("input_seq")) {
+      moved["last_input_seq"] = in["input_seq"];
+    }
+    broadcastAt(player, moved);
+  }
+
+  // Acknowledges the area and brings the client's view in line with it: a
+  // full update for everything that came into the area, since the client may
+  // have evicted it, and `interest_leave` for everything it stops hearing about.
+  void handleInterest(websocketpp::connection_hdl hdl, Session& session, const json& in) {
+    const Area area{in.value("x", 0), in.value("y", 0), std::max(0, in.value("w", 0)), std::max(0, in.value("h", 0))};
+    // Before the first `interest` the client was sent every entity.
+    const bool sentEverything = !session.interest;
+    std::unordered_set<std::string> previous;
+    previous.swap(session.inView);
+    session.interest = area;
+    send(hdl, {{"type", "interest_ack"}, {"x", area.x}, {"y", area.y}, {"w", area.w}, {"h", area.h}});
+
+    json entered = json::array();
+    json leftMobs = json::array();
+    json leftPlayers = json::array();
+    // Returns whether `e` came into view.
+    const auto classify = [&](const Entity& e, json& left) {
+      const bool wasSent = sentEverything || previous.count(e.id) > 0;
+      if (!area.contains(e.x, e.y)) {
+        if (wasSent) {
+          left.push_back(e.id);
+        }
+        return false;
+      }
+      session.inView.insert(e.id);
+      return !wasSent;
+    };
+    for (const Entity& mob : mobs_) {
+      if (classify(mob, leftMobs)) {
+        entered.push_back(mobJson(mob));
+      }
+    }
+    if (!entered.empty()) {
+      send(hdl, {{"type", "mob_update"}, {"mobs", std::move(entered)}});
+    }
+    forEachPlayer(session, [&](const Entity& player) {
+      if (classify(player, leftPlayers)) {
+        send(hdl, {{"type", "player_moved"}, {"player", playerJson(player)}});
+      }
+    });
+    if (!leftMobs.empty() || !leftPlayers.empty()) {
+      send(hdl, {{"type", "interest_leave"}, {"players", std::move(leftPlayers)}, {"mobs", std::move(leftMobs)}});
+    }
+  }
+
+  // Bots and other sessions' players, as `viewer` sees them.
+  template <typename Fn>
+  void forEachPlayer(const Session& viewer, Fn&& fn) const {
+    for (const Entity& bot : bots_) {
+      fn(bot);
+    }
+    for (const auto& [hdl, other] : sessions_) {
+      if (other.joined && &other != &viewer) {
+        fn(other.player);
+      }
+    }
+  }
+
+  // Whether `session` gets an update putting entity `id` at (x, y): anything
+  // inside its area, plus the update that takes a tracked entity out of it.
+  static bool follows(Session& session, const std::string& id, int x, int y) {
+    if (!session.interest) {
+      return true;
+    }
+    if (session.interest->contains(x, y)) {
+      session.inView.insert(id);
+      return true;
+    }
+    return session.inView.erase(id) > 0;
+  }
+
+  // After a broadcast that went to every session regardless of area.
+  void noteSent(const Entity& e) {
+    for (auto& [hdl, session] : sessions_) {
+      if (session.joined) {
+        follows(session, e.id, e.x, e.y);
+      }
+    }
+  }
+
+  void forget(const std::string& id) {
+    for (auto& [hdl, session] : sessions_) {
+      session.inView.erase(id);
+    }
+  }
+
+  void handleAttack(const Session& session, const std::string& mobId) {
+    const auto it = std::find_if(mobs_.begin(), mobs_.end(), [&](const Entity& m) { return m.id == mobId; });
+    if (it == mobs_.end()) {
+      return;
+    }
+    std::uniform_int_distribution<int> damage(5, 25);
+    if (hitMob(*it, session.player.id, damage(reactions_))) {
+      broadcastMobs(json::array({mobJson(*it)}));
+    }
+  }
+
+  const Entity* findNpc(const std::string& npcId) const {
+    const auto it = std::find_if(npcs_.begin(), npcs_.end(), [&](const Entity& n) { return n.id == npcId; });
+    return it == npcs_.end() ? nullptr : &*it;
+  }
+
+  void handleInteract(websocketpp::connection_hdl hdl, const std::string& npcId) {
+    const Entity* npc = findNpc(npcId);
+    if (npc == nullptr) {
+      return;
+    }
+    send(hdl, {{"type", "dialog_start"},
+               {"npc_id", npc->id},
+               {"npc_name", npc->name},
+               {"npc_role", "villager"},
+               {"node",
+                {{"id", "greeting"},
+                 {"text", "Busy day. The zone is crawling with adventurers."},
+                 {"responses",
+                  {{{"id", "work"}, {"text", "Any work for me?"}, {"next_node_id", "work"}},
+                   {{"id", "bye"}, {"text", "Farewell."}}}}}}});
+  }
+
+  void handleDialogSelect(websocketpp::connection_hdl hdl, const std::string& npcId, const std::string& responseId) {
+    const Entity* npc = findNpc(npcId);
+    if (npc == nullptr) {
+      return;
+    }
+    if (responseId == "work") {
+      send(hdl, {{"type", "dialog_update"},
+                 {"npc_id", npc->id},
+                 {"npc_name", npc->name},
+                 {"node",
+                  {{"id", "work"},
+                   {"text", "Thin out the slimes to the east."},
+                   {"responses", {{{"id", "accept"}, {"text", "On it."}, {"quest_trigger", "mock_slimes"}}}}}}});
+      return;
+    }
+    json end{{"type", "dialog_end"}, {"npc_id", npc->id}, {"npc_name", npc->name}};
+    if (responseId == "accept") {
+      end["quest_trigger"] = "mock_slimes";
+    }
+    send(hdl, end);
+  }
+
+  void stamp(json& msg) const { msg["server_time"] = serverTimeMs(); }
+
+  void send(websocketpp::connection_hdl hdl, json msg) {
+    const auto it = sessions_.find(hdl);
+    if (it == sessions_.end()) {
+      return;
+    }
+    sendTo(hdl, it->second, std::move(msg));
+  }
+
+  void sendTo(websocketpp::connection_hdl hdl, Session& session, json msg) {
+    stamp(msg);
+    deliver(hdl, session, msg, msg.dump());
+  }
+
+  // Gives `msg` the session's next `seq`, keeps it for a resume and writes it
+  // unless the session is parked. `text` is `msg` serialised without the seq,
+  // so a broadcast serialises once; binary encodings are per session.
+  void deliver(websocketpp::connection_hdl hdl, Session& session, const json& msg, const std::string& text) {
+    const std::uint64_t seq = ++session.seq;
+    std::string sequenced = "{\"seq\":" + std::to_string(seq) + "," + text.substr(1);
+    if (!session.parkedUntil) {
+      if (session.encoding == Encoding::Json) {
+        transmit(hdl, session.encoding, sequenced);
+      } else {
+        json copy = msg;
+        copy["seq"] = seq;
+        sendRaw(hdl, encodeBinary(copy, session.encoding), websocketpp::frame::opcode::binary);
+      }
+    }
+    session.backlog.emplace_back(seq, std::move(sequenced));
+    if (session.backlog.size() > kResumeBacklog) {
+      session.backlog.pop_front();
+    }
+  }
+
+  // Writes a message given as JSON text in `encoding`.
+  void transmit(websocketpp::connection_hdl hdl, Encoding encoding, const std::string& text) {
+    if (encoding == Encoding::Json) {
+      sendRaw(hdl, text, websocketpp::frame::opcode::text);
+    } else {
+      sendRaw(hdl, encodeBinary(json::parse(text), encoding), websocketpp::frame::opcode::binary);
+    }
+  }
+
+  // Serialised once and written to every joined session except `except`.
+  void broadcast(json msg, websocketpp::connection_hdl except = {}) {
+    if (sessions_.empty()) {
+      return;
+    }
+    stamp(msg);
+    const std::string text = msg.dump();
+    for (auto& [hdl, session] : sessions_) {
+      if (session.joined && (except.owner_before(hdl) || hdl.owner_before(except))) {
+        deliver(hdl, session, msg, text);
+      }
+    }
+  }
+
+  // A position update about `subject`, skipped for sessions that do not
+  // follow it there.
+  void broadcastAt(const Entity& subject, json msg) {
+    if (sessions_.empty()) {
+      return;
+    }
+    stamp(msg);
+    const std::string text = msg.dump();
+    for (auto& [hdl, session] : sessions_) {
+      if (session.joined && follows(session, subject.id, subject.x, subject.y)) {
+        deliver(hdl, session, msg, text);
+      }
+    }
+  }
+
+  // `mob_update` with each session's interest area applied to the array.
+  void broadcastMobs(json mobs) {
+    if (sessions_.empty()) {
+      return;
+    }
+    json msg{{"type", "mob_update"}, {"mobs", mobs}};
+    stamp(msg);
+    const std::string text = msg.dump();
+    for (auto& [hdl, session] : sessions_) {
+      if (!session.joined) {
+        continue;
+      }
+      if (!session.interest) {
+        deliver(hdl, session, msg, text);
+        continue;
+      }
+      json visible = json::array();
+      for (const json& mob : mobs) {
+        if (follows(session, mob.value("id", ""), mob.value("x", 0), mob.value("y", 0))) {
+          visible.push_back(mob);
+        }
+      }
+      if (visible.size() == mobs.size()) {
+        deliver(hdl, session, msg, text);
+      } else if (!visible.empty()) {
+        sendTo(hdl, session, {{"type", "mob_update"}, {"mobs", std::move(visible)}});
+      }
+    }
+  }
+
+  void sendRaw(websocketpp::connection_hdl hdl, const std::string& payload, websocketpp::frame::opcode::value opcode) {
+    websocketpp::lib::error_code ec;
+    server_.send(hdl, payload, opcode, ec);
+    if (!ec) {
+      ++sentMessages_;
+      sentBytes_ += payload.size();
+    }
+  }
+
+  void reportStats() {
+    const double elapsed = std::chrono::duration<double>(Clock::now() - lastReportAt_).count();
+    lastReportAt_ = Clock::now();
+    std::size_t joined = 0;
+    for (const auto& entry : sessions_) {
+      joined += entry.second.joined && !entry.second.parkedUntil ? 1 : 0;
+    }
+    // Uncompressed sessions put their payload on the wire as is.
+    DeflateTotals& deflated = deflateTotals();
+    const std::uint64_t wireBytes = sentBytes_ - std::min(sentBytes_, deflated.payload) + deflated.wire;
+    std::printf("[mock] t=%.0fs clients=%zu bots=%zu mobs=%zu out=%.0f msg/s %.1f KiB/s (wire %.1f KiB/s)\n",
+                static_cast<double>(tick_) / options_.tickHz, joined, bots_.size(), mobs_.size(),
+                static_cast<double>(sentMessages_) / elapsed, static_cast<double>(sentBytes_) / 1024.0 / elapsed,
+                static_cast<double>(wireBytes) / 1024.0 / elapsed);
+    sentMessages_ = 0;
+    sentBytes_ = 0;
+    deflated = DeflateTotals{};
+  }
+
+  WsServer& server_;
+  AccountStore& accounts_;
+  const Options& options_;
+  std::mt19937 rng_;        // drives the simulation only, so the world is reproducible
+  std::mt19937 reactions_;  // client-triggered outcomes
+  std::vector<std::string> rows_;
+  std::vector<Entity> npcs_;
+  std::vector<Entity> bots_;
+  std::vector<Entity> mobs_;
+  SessionMap sessions_;
+  Phase phase_;
+  std::size_t nextPhase_ = 0;
+  std::uint64_t tick_ = 0;
+  std::uint64_t nextBotId_ = 0;
+  std::uint64_t nextMobId_ = 0;
+  std::uint64_t nextGuestId_ = 0;
+  double combatBudget_ = 0.0;
+  Clock::time_point startedAt_;
+  Clock::time_point nextTickAt_;
+  Clock::time_point lastReportAt_ = Clock::now();
+  std::uint64_t sentMessages_ = 0;
+  std::uint64_t sentBytes_ = 0;
+};
+
+std::optional<Crowd> parseCrowd(const std::string& text) {
+  Crowd crowd;
+  if (std::sscanf(text.c_str(), "%d,%d,%d", &crowd.x, &crowd.y, &crowd.radius) != 3 || crowd.radius < 0) {
+    return std::nullopt;
+  }
+  return crowd;
+}
+
+Phase parsePhase(const json& node) {
+  Phase phase;
+  phase.atSec = node.value("at_s", 0.0);
+  if (node.contains("players")) {
+    phase.players = node["players"].get<int>();
+  }
+  if (node.contains("mobs")) {
+    phase.mobs = node["mobs"].get<int>();
+  }
+  if (node.contains("move_pct")) {
+    phase.movePct = node["move_pct"].get<double>();
+  }
+  if (node.contains("mob_move_pct")) {
+    phase.mobMovePct = node["mob_move_pct"].get<double>();
+  }
+  if (node.contains("combat_per_s")) {
+    phase.combatPerSec = node["combat_per_s"].get<double>();
+  }
+  if (node.contains("crowd")) {
+    phase.setsCrowd = true;
+    const json& crowd = node["crowd"];
+    if (crowd.is_object()) {
+      phase.crowd = Crowd{crowd.value("x", 0), crowd.value("y", 0), crowd.value("radius", 3)};
+    }
+  }
+  return phase;
+}
+
+bool loadScenario(const std::string& path, Options& options) {
+  std::ifstream in(path);
+  const json scenario = json::parse(in, nullptr, false);
+  if (!scenario.is_object()) {
+    std::fprintf(stderr, "Cannot read scenario %s\n", path.c_str());
+    return false;
+  }
+  try {
+    options.seed = scenario.value("seed", options.seed);
+    options.tickHz = scenario.value("tick_hz", options.tickHz);
+    options.npcs = scenario.value("npcs", options.npcs);
+    if (scenario.contains("map") && scenario["map"].is_object()) {
+      options.mapWidth = scenario["map"].value("width", options.mapWidth);
+      options.mapHeight = scenario["map"].value("height", options.mapHeight);
+    }
+    if (scenario.contains("phases") && scenario["phases"].is_array()) {
+      for (const json& node : scenario["phases"]) {
+        options.phases.push_back(parsePhase(node));
+      }
+    }
+  } catch (const json::exception& e) {
+    std::fprintf(stderr, "Invalid scenario %s: %s\n", path.c_str(), e.what());
+    return false;
+  }
+  std::stable_sort(options.phases.begin(), options.phases.end(),
+                   [](const Phase& a, const Phase& b) { return a.atSec < b.atSec; });
+  return true;
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+  std::string scenarioPath;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      std::printf(
+          "Usage: mock_world_server [--http-port N] [--ws-port N] [--seed N] [--tick-hz N]\n"
+          "                         [--map WxH] [--npcs N] [--players N] [--mobs N] [--move-pct P]\n"
+          "                         [--mob-move-pct P] [--combat-per-s N] [--crowd X,Y,R] [--scenario FILE]\n"
+          "                         [--deflate]\n");
+      std::exit(0);
+    }
+    if (arg == "--deflate") {
+#if MMORP_WS_DEFLATE
+      options.deflate = true;
+      continue;
+#else
+      std::fprintf(stderr, "--deflate needs a build with MMORP_WS_DEFLATE\n");
+      return false;
+#endif
+    }
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "Unknown or incomplete argument: %s\n", arg.c_str());
+      return false;
+    }
+    const std::string value = argv[++i];
+    const double number = std::atof(value.c_str());
+    if (arg == "--http-port") {
+      options.httpPort = static_cast<int>(number);
+    } else if (arg == "--ws-port") {
+      options.wsPort = static_cast<int>(number);
+    } else if (arg == "--seed") {
+      options.seed = static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+    } else if (arg == "--tick-hz") {
+      options.tickHz = number;
+    } else if (arg == "--map") {
+      if (std::sscanf(value.c_str(), "%dx%d", &options.mapWidth, &options.mapHeight) != 2) {
+        std::fprintf(stderr, "Invalid --map: %s\n", value.c_str());
+        return false;
+      }
+    } else if (arg == "--npcs") {
+      options.npcs = static_cast<int>(number);
+    } else if (arg == "--players") {
+      options.base.players = static_cast<int>(number);
+    } else if (arg == "--mobs") {
+      options.base.mobs = static_cast<int>(number);
+    } else if (arg == "--move-pct") {
+      options.base.movePct = number;
+    } else if (arg == "--mob-move-pct") {
+      options.base.mobMovePct = number;
+    } else if (arg == "--combat-per-s") {
+      options.base.combatPerSec = number;
+    } else if (arg == "--crowd") {
+      options.base.crowd = parseCrowd(value);
+      if (!options.base.crowd) {
+        std::fprintf(stderr, "Invalid --crowd (expected X,Y,R): %s\n", value.c_str());
+        return false;
+      }
+    } else if (arg == "--scenario") {
+      scenarioPath = value;
+    } else {
+      std::fprintf(stderr, "Unknown argument: %s\n", arg.c_str());
+      return false;
+    }
+  }
+  if (!scenarioPath.empty() && !loadScenario(scenarioPath, options)) {
+    return false;
+  }
+  if (options.tickHz <= 0.0 || options.mapWidth < 3 || options.mapHeight < 3) {
+    std::fprintf(stderr, "tick rate must be positive and the map at least 3x3\n");
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parseArgs(argc, argv, options)) {
+    return 1;
+  }
+
+  AccountStore accounts;
+  httplib::Server http;
+  installHttpRoutes(http, accounts);
+  if (!http.bind_to_port("0.0.0.0", options.httpPort)) {
+    std::fprintf(stderr, "Cannot bind HTTP port %d\n", options.httpPort);
+    return 1;
+  }
+  std::thread httpThread([&http] { http.listen_after_bind(); });
+
+#if MMORP_WS_DEFLATE
+  SwitchableDeflate<MockServerConfig::permessage_deflate_config>::accept() = options.deflate;
+#endif
+  WsServer server;
+  server.clear_access_channels(websocketpp::log::alevel::all);
+  server.clear_error_channels(websocketpp::log::elevel::all);
+  server.init_asio();
+  server.set_reuse_addr(true);
+
+  Zone zone(server, accounts, options);
+  server.set_validate_handler([&zone](websocketpp::connection_hdl hdl) { return zone.validate(hdl); });
+  server.set_open_handler([&zone](websocketpp::connection_hdl hdl) { zone.onOpen(hdl); });
+  server.set_close_handler([&zone](websocketpp::connection_hdl hdl) { zone.onClose(hdl); });
+  server.set_message_handler(
+      [&zone](websocketpp::connection_hdl hdl, WsServer::message_ptr msg) { zone.onMessage(hdl, msg); });
+
+  websocketpp::lib::error_code ec;
+  server.listen(static_cast<std::uint16_t>(options.wsPort), ec);
+  if (ec) {
+    std::fprintf(stderr, "Cannot listen on websocket port %d: %s\n", options.wsPort, ec.message().c_str());
+    http.stop();
+    httpThread.join();
+    return 1;
+  }
+  server.start_accept();
+  zone.start();
+  std::printf("[mock] http://localhost:%d  ws://localhost:%d%s  seed=%u tick=%.0fHz%s\n", options.httpPort,
+              options.wsPort, kWorldPath, options.seed, options.tickHz, options.deflate ? " deflate" : "");
+  server.run();
+
+  http.stop();
+  httpThread.join();
+  return 0;
+}